@@ -0,0 +1,91 @@
+#include "barrier.h"
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <limits.h>
+#endif
+
+static inline void cpuRelax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+void initSpinBarrier(SpinBarrier* barrier, int parties) {
+    barrier->parties = parties;
+    atomic_init(&barrier->spin, (sysconf(_SC_NPROCESSORS_ONLN) > 1) ? BARRIER_SPIN_MAX / 4 : 0);
+    atomic_init(&barrier->remaining, parties);
+    atomic_init(&barrier->sense, 0);
+    atomic_init(&barrier->sleepers, 0);
+#ifndef __linux__
+    pthread_mutex_init(&barrier->mutex, NULL);
+    pthread_cond_init(&barrier->cond, NULL);
+#endif
+}
+
+int spinBarrierWait(SpinBarrier* barrier, int* localSense) {
+    int sense = !*localSense;
+    *localSense = sense;
+
+    if (atomic_fetch_sub(&barrier->remaining, 1) == 1) {
+        // last to arrive: reset for the next round, then release everyone
+        atomic_store_explicit(&barrier->remaining, barrier->parties, memory_order_relaxed);
+        atomic_store(&barrier->sense, sense);
+        if (atomic_load(&barrier->sleepers) > 0) {
+#ifdef __linux__
+            syscall(SYS_futex, &barrier->sense, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#else
+            pthread_mutex_lock(&barrier->mutex);
+            pthread_cond_broadcast(&barrier->cond);
+            pthread_mutex_unlock(&barrier->mutex);
+#endif
+        }
+        return 1;
+    }
+
+    int budget = atomic_load_explicit(&barrier->spin, memory_order_relaxed);
+    for (int i = 0; i < budget; i++) {
+        if (atomic_load_explicit(&barrier->sense, memory_order_acquire) == sense) {
+            // spinning was enough, allow a little more next time
+            if (budget < BARRIER_SPIN_MAX) {
+                atomic_store_explicit(&barrier->spin, budget + budget / 8 + 1, memory_order_relaxed);
+            }
+            return 0;
+        }
+        cpuRelax();
+    }
+
+    atomic_fetch_add(&barrier->sleepers, 1);
+#ifdef __linux__
+    while (atomic_load(&barrier->sense) != sense) {
+        // sleeps only while sense still holds the old value
+        syscall(SYS_futex, &barrier->sense, FUTEX_WAIT_PRIVATE, !sense, NULL, NULL, 0);
+    }
+#else
+    pthread_mutex_lock(&barrier->mutex);
+    while (atomic_load(&barrier->sense) != sense) {
+        pthread_cond_wait(&barrier->cond, &barrier->mutex);
+    }
+    pthread_mutex_unlock(&barrier->mutex);
+#endif
+    atomic_fetch_sub(&barrier->sleepers, 1);
+
+    // parked anyway, the spin was wasted
+    if (budget > BARRIER_SPIN_MIN) {
+        atomic_store_explicit(&barrier->spin, budget / 2, memory_order_relaxed);
+    }
+    return 0;
+}
+
+void destroySpinBarrier(SpinBarrier* barrier) {
+#ifndef __linux__
+    pthread_mutex_destroy(&barrier->mutex);
+    pthread_cond_destroy(&barrier->cond);
+#else
+    (void)barrier;
+#endif
+}
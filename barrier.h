@@ -0,0 +1,39 @@
+#ifndef BARRIER_H
+#define BARRIER_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define BARRIER_SPIN_MAX 20000 // longest spin before parking
+#define BARRIER_SPIN_MIN 64
+
+/*
+ * Sense reversing barrier. Arriving threads count down remaining, the last
+ * one resets it and flips sense, and the others wait for sense to match
+ * their own flipped copy. Waiters spin first and then park on a futex
+ * (a condition variable off linux). The spin budget adapts: it grows when
+ * spinning was enough and shrinks when waiters had to park anyway.
+ * remaining and sense sit on their own cache lines.
+ */
+typedef struct SpinBarrier {
+    int parties;
+    atomic_int spin;     // current spin budget, 0 on a single cpu
+    char pad0[64 - 2 * sizeof(int)];
+    atomic_int remaining;
+    char pad1[64 - sizeof(atomic_int)];
+    atomic_int sense;    // also the futex word
+    atomic_int sleepers; // parked waiters, the last arrival only wakes if > 0
+#ifndef __linux__
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+#endif
+} __attribute__((aligned(64))) SpinBarrier;
+
+void initSpinBarrier(SpinBarrier* barrier, int parties);
+
+// localSense is per thread and starts at 0, returns 1 in the last thread to arrive
+int spinBarrierWait(SpinBarrier* barrier, int* localSense);
+
+void destroySpinBarrier(SpinBarrier* barrier);
+
+#endif
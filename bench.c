@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bench.h"
+
+double wallTime(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+void initBench(Bench* bench, const char* title, int warmups, int reps) {
+    bench->title = title;
+    bench->quiet = 0;
+    bench->warmups = warmups < 0 ? 0 : warmups;
+    bench->reps = reps < 1 ? 1 : reps;
+    bench->results = NULL;
+    bench->count = 0;
+    bench->capacity = 0;
+}
+
+static int compareDoubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+BenchResult* benchRun(Bench* bench, const char* name, void (*run)(void* ctx), void* ctx,
+                      double work, const char* unit) {
+    if (bench->count == bench->capacity) {
+        bench->capacity = bench->capacity ? bench->capacity * 2 : 8;
+        bench->results = (BenchResult*)realloc(bench->results, bench->capacity * sizeof(BenchResult));
+        if (!bench->results) {
+            printf("Memory allocation failed\n");
+            exit(1);
+        }
+    }
+
+    for (int i = 0; i < bench->warmups; i++) run(ctx);
+
+    double* samples = (double*)malloc(bench->reps * sizeof(double));
+    if (!samples) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    double sum = 0.0;
+    for (int i = 0; i < bench->reps; i++) {
+        double start = wallTime();
+        run(ctx);
+        samples[i] = wallTime() - start;
+        sum += samples[i];
+    }
+    qsort(samples, bench->reps, sizeof(double), compareDoubles);
+
+    BenchResult* r = &bench->results[bench->count++];
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->unit = unit ? unit : "";
+    r->work = work;
+    r->reps = bench->reps;
+    r->min = samples[0];
+    int mid = bench->reps / 2;
+    r->median = (bench->reps % 2) ? samples[mid] : (samples[mid - 1] + samples[mid]) / 2;
+    // nearest rank
+    int rank = (95 * bench->reps + 99) / 100;
+    r->p95 = samples[rank - 1];
+    r->mean = sum / bench->reps;
+    r->perSecond = (work > 0 && r->median > 0) ? work / r->median : 0.0;
+    r->speedup = r->median > 0 ? bench->results[0].median / r->median : 0.0;
+    free(samples);
+
+    if (!bench->quiet) {
+        printf("time to calc %-16s median \e[1m%lf\e[m  p95 %lf  min %lf", r->name, r->median, r->p95, r->min);
+        if (r->perSecond > 0) printf("  %.1lf M %s/s", r->perSecond * 1e-6, r->unit);
+        printf("  x%.2lf\n", r->speedup);
+    }
+    return r;
+}
+
+int writeBenchCSV(Bench* bench, const char* path) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    fprintf(f, "bench,variant,reps,min_s,median_s,p95_s,mean_s,work,unit,per_s,speedup\n");
+    for (int i = 0; i < bench->count; i++) {
+        BenchResult* r = &bench->results[i];
+        fprintf(f, "%s,%s,%d,%.9f,%.9f,%.9f,%.9f,%.0f,%s,%.3f,%.4f\n", bench->title, r->name, r->reps,
+                r->min, r->median, r->p95, r->mean, r->work, r->unit, r->perSecond, r->speedup);
+    }
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+int writeBenchJSON(Bench* bench, const char* path) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    fprintf(f, "{\"bench\": \"%s\", \"warmups\": %d, \"reps\": %d, \"results\": [", bench->title,
+            bench->warmups, bench->reps);
+    for (int i = 0; i < bench->count; i++) {
+        BenchResult* r = &bench->results[i];
+        fprintf(f, "%s\n  {\"variant\": \"%s\", \"min_s\": %.9f, \"median_s\": %.9f, \"p95_s\": %.9f, "
+                   "\"mean_s\": %.9f, \"work\": %.0f, \"unit\": \"%s\", \"per_s\": %.3f, \"speedup\": %.4f}",
+                i ? "," : "", r->name, r->min, r->median, r->p95, r->mean, r->work, r->unit, r->perSecond,
+                r->speedup);
+    }
+    fprintf(f, "\n]}\n");
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+void freeBench(Bench* bench) {
+    free(bench->results);
+    bench->results = NULL;
+    bench->count = 0;
+    bench->capacity = 0;
+}
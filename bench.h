@@ -0,0 +1,56 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#define BENCH_WARMUPS 1 // untimed runs before the samples, faults pages and warms caches
+#define BENCH_REPS    5 // timed runs per variant
+
+/*
+ * Wall clock benchmark harness. Each variant runs warmups times untimed,
+ * then reps times on CLOCK_MONOTONIC, which unlike clock() doesn't add up
+ * the CPU time of every thread. A result keeps the order statistics of
+ * the samples, the throughput of the median run and the speedup against
+ * the first variant of its Bench, the serial baseline.
+ */
+struct BenchResult {
+    char name[32];
+    const char* unit;  // what work counts, "edges" for the rank kernels
+    double work;       // units one run processes, 0 when not meaningful
+    int reps;
+    double min;
+    double median;
+    double p95;
+    double mean;
+    double perSecond;  // work / median
+    double speedup;    // first result's median / median
+};
+
+typedef struct BenchResult BenchResult;
+
+struct Bench {
+    const char* title;
+    int quiet;         // 1 keeps benchRun from printing, for callers with their own tables
+    int warmups;
+    int reps;
+    BenchResult* results;
+    int count;
+    int capacity;
+};
+
+typedef struct Bench Bench;
+
+// seconds on CLOCK_MONOTONIC, for timing anything outside a Bench too
+double wallTime(void);
+
+void initBench(Bench* bench, const char* title, int warmups, int reps);
+
+// times run(ctx), prints the result line and returns it
+BenchResult* benchRun(Bench* bench, const char* name, void (*run)(void* ctx), void* ctx,
+                      double work, const char* unit);
+
+// results as one row each, under a header line; return 0, or -1 when path can't be written
+int writeBenchCSV(Bench* bench, const char* path);
+int writeBenchJSON(Bench* bench, const char* path);
+
+void freeBench(Bench* bench);
+
+#endif
@@ -0,0 +1,162 @@
+#include <string.h>
+#include "blocked.h"
+
+static int *copyOutDegree(Graph *graph, CSRGraph *csr, int n) {
+    int *outDegree = (int *)malloc(n * sizeof(int));
+    if (!outDegree) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    memcpy(outDegree, csr ? csr->outDegree : graph->adjacencyListsOutLength, n * sizeof(int));
+    return outDegree;
+}
+
+// edges of each block into offsets, turned into the starts of the blocks
+static void prefixSum(long *offsets, int blocks) {
+    long sum = 0;
+    for (int b = 0; b <= blocks; b++) {
+        long count = offsets[b];
+        offsets[b] = sum;
+        sum += count;
+    }
+}
+
+TiledGraph *createTiledGraph(Graph *graph, CSRGraph *csr, int bits) {
+    int n = csr ? (int)csr->numVertices : (int)graph->numVertices;
+    TiledGraph *tiled = (TiledGraph *)malloc(sizeof(TiledGraph));
+    if (!tiled) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    tiled->numVertices = n;
+    tiled->bits = bits;
+    tiled->numTiles = (int)(((long)n + (1L << bits) - 1) >> bits);
+    tiled->tileOffsets = (long *)calloc(tiled->numTiles + 1, sizeof(long));
+    if (!tiled->tileOffsets) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+
+    for (int v = 0; v < n; v++) {
+        if (csr) {
+            for (long k = csr->inOffsets[v]; k < csr->inOffsets[v + 1]; k++) {
+                tiled->tileOffsets[csr->inNeighbors[k] >> bits]++;
+            }
+        } else {
+            for (node *u = graph->adjacencyListsIn[v]; u != NULL; u = u->next) {
+                tiled->tileOffsets[u->v >> bits]++;
+            }
+        }
+    }
+    prefixSum(tiled->tileOffsets, tiled->numTiles);
+    long m = tiled->tileOffsets[tiled->numTiles];
+    tiled->numEdges = m;
+    tiled->src = (vertex *)malloc((m > 0 ? m : 1) * sizeof(vertex));
+    tiled->dst = (vertex *)malloc((m > 0 ? m : 1) * sizeof(vertex));
+    long *fill = (long *)malloc((tiled->numTiles > 0 ? tiled->numTiles : 1) * sizeof(long));
+    if (!tiled->src || !tiled->dst || !fill) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+
+    // destinations in ascending order, so every tile comes out sorted by them
+    memcpy(fill, tiled->tileOffsets, tiled->numTiles * sizeof(long));
+    for (int v = 0; v < n; v++) {
+        if (csr) {
+            for (long k = csr->inOffsets[v]; k < csr->inOffsets[v + 1]; k++) {
+                long slot = fill[csr->inNeighbors[k] >> bits]++;
+                tiled->src[slot] = csr->inNeighbors[k];
+                tiled->dst[slot] = v;
+            }
+        } else {
+            for (node *u = graph->adjacencyListsIn[v]; u != NULL; u = u->next) {
+                long slot = fill[u->v >> bits]++;
+                tiled->src[slot] = u->v;
+                tiled->dst[slot] = v;
+            }
+        }
+    }
+    free(fill);
+
+    tiled->outDegree = copyOutDegree(graph, csr, n);
+    return tiled;
+}
+
+BinnedGraph *createBinnedGraph(Graph *graph, CSRGraph *csr, int bits) {
+    int n = csr ? (int)csr->numVertices : (int)graph->numVertices;
+    BinnedGraph *binned = (BinnedGraph *)malloc(sizeof(BinnedGraph));
+    if (!binned) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    binned->numVertices = n;
+    binned->bits = bits;
+    binned->numBins = (int)(((long)n + (1L << bits) - 1) >> bits);
+    binned->outDegree = copyOutDegree(graph, csr, n);
+
+    // the out direction, sources push in id order
+    binned->outOffsets = (long *)malloc((n + 1) * sizeof(long));
+    if (!binned->outOffsets) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    binned->outOffsets[0] = 0;
+    for (int u = 0; u < n; u++) binned->outOffsets[u + 1] = binned->outOffsets[u] + binned->outDegree[u];
+    long m = binned->outOffsets[n];
+    binned->numEdges = m;
+    binned->outNeighbors = (vertex *)malloc((m > 0 ? m : 1) * sizeof(vertex));
+    if (!binned->outNeighbors) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    if (csr) {
+        memcpy(binned->outNeighbors, csr->outNeighbors, m * sizeof(vertex));
+    } else {
+        for (int u = 0; u < n; u++) {
+            long k = binned->outOffsets[u];
+            for (node *v = graph->adjacencyListsOut[u]; v != NULL; v = v->next) binned->outNeighbors[k++] = v->v;
+        }
+    }
+
+    binned->binOffsets = (long *)calloc(binned->numBins + 1, sizeof(long));
+    if (!binned->binOffsets) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    for (long k = 0; k < m; k++) binned->binOffsets[binned->outNeighbors[k] >> bits]++;
+    prefixSum(binned->binOffsets, binned->numBins);
+
+    // the same walk the engine pushes in, so slot i of a bin always gets the same destination
+    binned->binDst = (vertex *)malloc((m > 0 ? m : 1) * sizeof(vertex));
+    long *fill = (long *)malloc((binned->numBins > 0 ? binned->numBins : 1) * sizeof(long));
+    if (!binned->binDst || !fill) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    memcpy(fill, binned->binOffsets, binned->numBins * sizeof(long));
+    for (long k = 0; k < m; k++) {
+        vertex v = binned->outNeighbors[k];
+        binned->binDst[fill[v >> bits]++] = v;
+    }
+    free(fill);
+    return binned;
+}
+
+void freeTiledGraph(TiledGraph *tiled) {
+    if (!tiled) return;
+    free(tiled->tileOffsets);
+    free(tiled->src);
+    free(tiled->dst);
+    free(tiled->outDegree);
+    free(tiled);
+}
+
+void freeBinnedGraph(BinnedGraph *binned) {
+    if (!binned) return;
+    free(binned->outOffsets);
+    free(binned->outNeighbors);
+    free(binned->binOffsets);
+    free(binned->binDst);
+    free(binned->outDegree);
+    free(binned);
+}
@@ -0,0 +1,57 @@
+#ifndef BLOCKED_H
+#define BLOCKED_H
+
+#include "graph.h"
+
+// log2 of the vertices per tile or bin, 2^18 floats of contrib or sums are 1MB
+#define BLOCK_BITS 18
+
+/*
+ * Edge layouts for graphs whose ranks don't fit in cache, so the pull
+ * gather misses on nearly every edge.
+ *
+ * TiledGraph cuts the edges into tiles by source range. A tile's edges are
+ * sorted by destination, so summing tile after tile reads a contrib slice
+ * that stays cached, and walks the sums front to back once per tile.
+ *
+ * BinnedGraph is for propagation blocking. Sources push their contribution
+ * into one bin per destination range, then each bin is added into its
+ * slice of sums. The destination of each slot never changes between
+ * iterations, so only the values are written per iteration and binDst is
+ * built once.
+ */
+struct TiledGraph {
+    unsigned int numVertices;
+    long numEdges;
+    int bits;           // tile t holds the sources t << bits .. ((t+1) << bits) - 1
+    int numTiles;
+    long* tileOffsets;  // numTiles+1 entries
+    vertex* src;        // numEdges entries, tile after tile
+    vertex* dst;        // ascending inside a tile
+    int* outDegree;
+};
+
+typedef struct TiledGraph TiledGraph;
+
+struct BinnedGraph {
+    unsigned int numVertices;
+    long numEdges;
+    int bits;           // bin b holds the destinations b << bits .. ((b+1) << bits) - 1
+    int numBins;
+    long* outOffsets;   // numVertices+1 entries
+    vertex* outNeighbors;
+    long* binOffsets;   // numBins+1 entries
+    vertex* binDst;     // destination of every slot, in the order the sources push
+    int* outDegree;
+};
+
+typedef struct BinnedGraph BinnedGraph;
+
+// from csr when given, from the lists of graph otherwise, like partitionByInEdges
+TiledGraph * createTiledGraph(Graph *graph, CSRGraph *csr, int bits);
+BinnedGraph * createBinnedGraph(Graph *graph, CSRGraph *csr, int bits);
+
+void freeTiledGraph(TiledGraph *tiled);
+void freeBinnedGraph(BinnedGraph *binned);
+
+#endif
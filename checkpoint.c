@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "checkpoint.h"
+#include "graphfile.h"
+
+#define BYTE_ORDER_MARK 0x01020304u
+
+_Static_assert(sizeof(CheckpointHeader) == 64, "checkpoint header must stay 64 bytes");
+
+int writeCheckpoint(const char *path, const float *ranks, unsigned int numVertices, long iteration,
+                    double l1, double linf) {
+    CheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.numVertices = numVertices;
+    header.iteration = iteration;
+    header.l1 = l1;
+    header.linf = linf;
+    header.checksum = checksumBytes(0, ranks, (size_t)numVertices * sizeof(float));
+
+    size_t length = strlen(path);
+    char *temp = (char *)malloc(length + 5);
+    if (!temp) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    memcpy(temp, path, length);
+    memcpy(temp + length, ".tmp", 5);
+
+    FILE *f = fopen(temp, "wb");
+    if (!f) {
+        perror(temp);
+        free(temp);
+        return -1;
+    }
+    int failed = fwrite(&header, sizeof(header), 1, f) != 1 ||
+                 (numVertices > 0 && fwrite(ranks, sizeof(float), numVertices, f) != numVertices);
+    if (fclose(f) != 0) failed = 1;
+    if (failed || rename(temp, path) != 0) {
+        perror(failed ? temp : path);
+        remove(temp);
+        free(temp);
+        return -1;
+    }
+    free(temp);
+    return 0;
+}
+
+float *readCheckpoint(const char *path, CheckpointHeader *header) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return NULL;
+    }
+    CheckpointHeader h;
+    const char *error = NULL;
+    float *ranks = NULL;
+    if (fread(&h, sizeof(h), 1, f) != 1) {
+        error = "too short for a checkpoint";
+    } else if (memcmp(h.magic, CHECKPOINT_MAGIC, sizeof(h.magic)) != 0) {
+        error = "not a checkpoint";
+    } else if (h.version != CHECKPOINT_VERSION) {
+        error = "unsupported checkpoint version";
+    } else if (h.byteOrder != BYTE_ORDER_MARK) {
+        error = "written with another byte order";
+    } else {
+        ranks = (float *)malloc((h.numVertices > 0 ? h.numVertices : 1) * sizeof(float));
+        if (!ranks) {
+            printf("Memory allocation failed\n");
+            exit(1);
+        }
+        if (fread(ranks, sizeof(float), h.numVertices, f) != h.numVertices) {
+            error = "truncated ranks";
+        } else if (checksumBytes(0, ranks, h.numVertices * sizeof(float)) != h.checksum) {
+            error = "checksum mismatch";
+        }
+    }
+    fclose(f);
+    if (error) {
+        fprintf(stderr, "%s: %s\n", path, error);
+        free(ranks);
+        return NULL;
+    }
+    if (header) *header = h;
+    return ranks;
+}
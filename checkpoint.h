@@ -0,0 +1,36 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdint.h>
+
+#define CHECKPOINT_MAGIC   "PRRANKS" // 8 bytes with the terminator
+#define CHECKPOINT_VERSION 1
+
+/*
+ * On-disk rank vector: a 64 byte header, then the numVertices floats as
+ * they sit in memory, in native byte order like the graph files. The file
+ * is written next to path and renamed over it, so a run killed while
+ * writing leaves the previous checkpoint whole.
+ */
+struct CheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;    // 0x01020304 as the writer stored it
+    uint64_t numVertices;
+    uint64_t iteration;    // iterations that produced the ranks, resumed runs included
+    double l1;             // residuals of the last of them
+    double linf;
+    uint64_t checksum;     // of the ranks
+    char pad[8];           // header is 64 bytes
+};
+
+typedef struct CheckpointHeader CheckpointHeader;
+
+// returns 0, or -1 after printing why the file couldn't be written
+int writeCheckpoint(const char *path, const float *ranks, unsigned int numVertices, long iteration,
+                    double l1, double linf);
+
+// malloced ranks, header->numVertices of them, NULL after printing why; header may be NULL
+float * readCheckpoint(const char *path, CheckpointHeader *header);
+
+#endif
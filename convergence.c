@@ -0,0 +1,80 @@
+#include "convergence.h"
+#include "checkpoint.h"
+
+void initConvergence(Convergence* conv, double tolerance, int norm, int maxIterations) {
+    conv->tolerance = tolerance;
+    conv->norm = norm;
+    conv->maxIterations = maxIterations;
+    conv->iterations = 0;
+    conv->initial = NULL;
+    conv->startIteration = 0;
+    conv->checkpoint = NULL;
+    conv->checkpointInterval = 0;
+    conv->l1   = (double*) malloc(maxIterations * sizeof(double));
+    conv->linf = (double*) malloc(maxIterations * sizeof(double));
+    if (!conv->l1 || !conv->linf) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+}
+
+int recordResidual(Convergence* conv, int iter, double l1, double linf) {
+    // kernels pass NULL when they run a fixed iteration count
+    if (conv == NULL) return 0;
+    // the engines count iterations on their own, past the history there is no room to record
+    if (iter >= conv->maxIterations) return 1;
+
+    conv->l1[iter] = l1;
+    conv->linf[iter] = linf;
+    conv->iterations = iter + 1;
+
+    double residual = (conv->norm == NORM_LINF) ? linf : l1;
+    return conv->tolerance > 0 && residual < conv->tolerance;
+}
+
+int recordIteration(Convergence* conv, int iter, double l1, double linf, const float* ranks, int numVertices) {
+    int stop = recordResidual(conv, iter, l1, linf);
+    if (conv == NULL || conv->checkpoint == NULL) return stop;
+
+    int interval = conv->checkpointInterval;
+    int due = stop || iter + 1 == conv->maxIterations || (interval > 0 && (iter + 1) % interval == 0);
+    // a failed write is reported and the run goes on, the previous checkpoint is still whole
+    if (due) writeCheckpoint(conv->checkpoint, ranks, numVertices, conv->startIteration + iter + 1, l1, linf);
+    return stop;
+}
+
+void warmStart(Convergence* conv, const float* initial, long startIteration) {
+    conv->initial = initial;
+    conv->startIteration = startIteration;
+}
+
+void setCheckpoint(Convergence* conv, const char* path, int interval) {
+    conv->checkpoint = path;
+    conv->checkpointInterval = interval;
+}
+
+double lastResidual(Convergence* conv) {
+    if (conv->iterations == 0) return 0.0;
+    int last = conv->iterations - 1;
+    return (conv->norm == NORM_LINF) ? conv->linf[last] : conv->l1[last];
+}
+
+void printConvergence(Convergence* conv, const char* name, int history) {
+    printf("%-9s %s after %d iterations, %s residual %e (tolerance %e)\n",
+           name,
+           (conv->tolerance > 0 && lastResidual(conv) < conv->tolerance) ? "converged" : "stopped",
+           conv->iterations,
+           (conv->norm == NORM_LINF) ? "Linf" : "L1",
+           lastResidual(conv), conv->tolerance);
+
+    if (!history) return;
+    for (int i = 0; i < conv->iterations; i++) {
+        printf("  iter %4d  L1 %e  Linf %e\n", i, conv->l1[i], conv->linf[i]);
+    }
+}
+
+void freeConvergence(Convergence* conv) {
+    free(conv->l1);
+    free(conv->linf);
+    conv->l1 = conv->linf = NULL;
+}
@@ -0,0 +1,58 @@
+#ifndef CONVERGENCE_H
+#define CONVERGENCE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NORM_L1   0 // sum of |newRanks[i] - ranks[i]|
+#define NORM_LINF 1 // max of |newRanks[i] - ranks[i]|
+
+/*
+ * Tolerance driven termination for the PageRank kernels. The kernels
+ * accumulate the change between ranks and newRanks while they write
+ * newRanks and stop once it drops below tolerance in the chosen norm,
+ * or after maxIterations. Both norms are kept for every iteration run.
+ *
+ * The same struct carries how a run starts and what it leaves behind: the
+ * engines start from initial instead of the uniform vector when it is set,
+ * and recordIteration rewrites a checkpoint file every checkpointInterval
+ * iterations and once more when the run stops.
+ */
+struct Convergence {
+    double tolerance;  // 0 runs all maxIterations
+    int norm;          // NORM_L1 or NORM_LINF
+    int maxIterations;
+    int iterations;    // iterations actually run
+    double* l1;        // l1[iter], maxIterations entries
+    double* linf;      // linf[iter], maxIterations entries
+    const float* initial;     // start vector, NULL for the uniform one
+    long startIteration;      // iterations behind initial, counted on in checkpoints
+    const char* checkpoint;   // NULL writes none
+    int checkpointInterval;
+};
+
+typedef struct Convergence Convergence;
+
+void initConvergence(Convergence* conv, double tolerance, int norm, int maxIterations);
+
+// stores the residuals of iteration iter, returns 1 once the run should stop,
+// also for an iter past maxIterations, which is not stored
+int recordResidual(Convergence* conv, int iter, double l1, double linf);
+
+// recordResidual, then the checkpoint of ranks, the vector iteration iter produced, when one is due
+int recordIteration(Convergence* conv, int iter, double l1, double linf, const float* ranks, int numVertices);
+
+// the run starts from initial, which already had startIteration iterations, e.g. a readCheckpoint vector
+void warmStart(Convergence* conv, const float* initial, long startIteration);
+
+// interval <= 0 writes the checkpoint only when the run stops
+void setCheckpoint(Convergence* conv, const char* path, int interval);
+
+// the last residual in the chosen norm
+double lastResidual(Convergence* conv);
+
+void printConvergence(Convergence* conv, const char* name, int history);
+
+void freeConvergence(Convergence* conv);
+
+#endif
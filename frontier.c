@@ -0,0 +1,57 @@
+#include <string.h>
+#include "frontier.h"
+
+Frontier *createFrontier(int numVertices) {
+    Frontier *frontier = (Frontier *)malloc(sizeof(Frontier));
+    if (!frontier) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    frontier->numVertices = numVertices;
+    frontier->words = ((long)numVertices + 63) / 64;
+    frontier->ids = (int *)malloc((numVertices > 0 ? numVertices : 1) * sizeof(int));
+    frontier->bits = (atomic_ulong *)calloc(frontier->words > 0 ? frontier->words : 1, sizeof(atomic_ulong));
+    if (!frontier->ids || !frontier->bits) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    frontier->dense = 0;
+    atomic_init(&frontier->count, 0);
+    frontier->edges = 0;
+    return frontier;
+}
+
+void clearFrontier(Frontier *frontier) {
+    int count = atomic_load_explicit(&frontier->count, memory_order_relaxed);
+    if (frontier->dense) {
+        memset((void *)frontier->bits, 0, frontier->words * sizeof(atomic_ulong));
+    } else {
+        // a sparse set is cheaper to clear bit by bit than all the words
+        for (int i = 0; i < count; i++) {
+            atomic_store_explicit(&frontier->bits[frontier->ids[i] >> 6], 0, memory_order_relaxed);
+        }
+    }
+    frontier->dense = 0;
+    atomic_store_explicit(&frontier->count, 0, memory_order_relaxed);
+    frontier->edges = 0;
+}
+
+void frontierToSparse(Frontier *frontier) {
+    int count = 0;
+    for (long w = 0; w < frontier->words; w++) {
+        unsigned long word = atomic_load_explicit(&frontier->bits[w], memory_order_relaxed);
+        while (word) {
+            frontier->ids[count++] = (int)(w * 64 + __builtin_ctzl(word));
+            word &= word - 1;
+        }
+    }
+    atomic_store_explicit(&frontier->count, count, memory_order_relaxed);
+    frontier->dense = 0;
+}
+
+void freeFrontier(Frontier *frontier) {
+    if (!frontier) return;
+    free(frontier->ids);
+    free((void *)frontier->bits);
+    free(frontier);
+}
@@ -0,0 +1,48 @@
+#ifndef FRONTIER_H
+#define FRONTIER_H
+
+#include <stdatomic.h>
+#include "graph.h"
+
+/*
+ * Set of active vertices for the push engines. The bitmap always holds the
+ * set, and a sparse frontier also lists its vertices in ids, so a round
+ * can walk a few thousand active vertices without scanning all N bits,
+ * or test membership per in-edge once most of the graph is active.
+ * Adding is a fetch_or on the vertex's word, so threads pushing to the
+ * same vertex list it only once.
+ */
+struct Frontier {
+    int numVertices;
+    int dense;            // ids is stale, only bits holds the set
+    atomic_int count;     // vertices in the set, the filled part of ids when sparse
+    long edges;           // out-edges of those vertices, for the density switch
+    int* ids;             // numVertices entries
+    atomic_ulong* bits;   // (numVertices + 63) / 64 words
+    long words;
+};
+
+typedef struct Frontier Frontier;
+
+Frontier * createFrontier(int numVertices);
+
+// empties the set, walking ids when sparse, every word when dense
+void clearFrontier(Frontier *frontier);
+
+// sets the bit of v, returns 1 when it was clear, the caller then lists v
+static inline int markVertex(Frontier *frontier, vertex v) {
+    unsigned long bit = 1UL << (v & 63);
+    if (atomic_load_explicit(&frontier->bits[v >> 6], memory_order_relaxed) & bit) return 0;
+    return !(atomic_fetch_or_explicit(&frontier->bits[v >> 6], bit, memory_order_relaxed) & bit);
+}
+
+static inline int inFrontier(Frontier *frontier, vertex v) {
+    return (atomic_load_explicit(&frontier->bits[v >> 6], memory_order_relaxed) >> (v & 63)) & 1;
+}
+
+// rebuilds ids from the bitmap, in ascending order
+void frontierToSparse(Frontier *frontier);
+
+void freeFrontier(Frontier *frontier);
+
+#endif
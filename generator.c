@@ -0,0 +1,293 @@
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include "generator.h"
+#include "steal.h"
+
+// streams of one generator, independent of which thread reads them
+typedef struct CounterRng {
+    uint64_t key;
+    uint64_t counter;
+} CounterRng;
+
+// one per task, written only by the task generating it
+typedef struct GenTask {
+    long first; // rows or edges first .. last-1
+    long last;
+    vertex* src;
+    vertex* dst;
+    long count;
+    long capacity;
+} GenTask;
+
+typedef struct GenJob {
+    GenTask* tasks;
+    uint64_t seed;
+    int n;
+    double p;      // Erdos-Renyi
+    double a, b, c; // R-MAT
+    int scale;     // R-MAT, 2^scale >= n
+    int d;         // Barabasi-Albert
+    EdgeList* edges;
+    long* firstEdge;
+} GenJob;
+
+// splitmix64 finalizer
+static inline uint64_t mix64(uint64_t z) {
+    z += 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static inline CounterRng rngStream(uint64_t seed, uint64_t stream) {
+    CounterRng rng = {mix64(seed ^ mix64(stream)), 0};
+    return rng;
+}
+
+static inline uint64_t rngNext(CounterRng *rng) {
+    return mix64(rng->key + 0x632be59bd9b4e019ULL * rng->counter++);
+}
+
+// uniform in [0, 1)
+static inline double rngUniform(CounterRng *rng) {
+    return (rngNext(rng) >> 11) * 0x1.0p-53;
+}
+
+// uniform in [0, range)
+static inline uint64_t rngBelow(CounterRng *rng, uint64_t range) {
+    return (uint64_t)(((unsigned __int128)rngNext(rng) * range) >> 64);
+}
+
+static int defaultThreads(int threads) {
+    if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    return threads < 1 ? 1 : threads;
+}
+
+static EdgeList *allocEdgeList(int n, long m) {
+    EdgeList *edges = (EdgeList *)malloc(sizeof(EdgeList));
+    if (!edges) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    edges->numVertices = n;
+    edges->numEdges = m;
+    // +1 so an edgeless graph still gets a valid pointer
+    edges->src = (vertex *)malloc((m + 1) * sizeof(vertex));
+    edges->dst = (vertex *)malloc((m + 1) * sizeof(vertex));
+    if (!edges->src || !edges->dst) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    return edges;
+}
+
+// splits first .. last-1 into even tasks
+static GenTask *splitTasks(long total, int count) {
+    GenTask *tasks = (GenTask *)calloc(count, sizeof(GenTask));
+    if (!tasks) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    for (int t = 0; t < count; t++) {
+        tasks[t].first = total * t / count;
+        tasks[t].last = total * (t + 1) / count;
+    }
+    return tasks;
+}
+
+static void pushEdge(GenTask *task, vertex s, vertex d) {
+    if (task->count == task->capacity) {
+        task->capacity = task->capacity ? task->capacity * 2 : 1024;
+        task->src = (vertex *)realloc(task->src, task->capacity * sizeof(vertex));
+        task->dst = (vertex *)realloc(task->dst, task->capacity * sizeof(vertex));
+        if (!task->src || !task->dst) {
+            printf("Memory allocation failed\n");
+            exit(1);
+        }
+    }
+    task->src[task->count] = s;
+    task->dst[task->count] = d;
+    task->count++;
+}
+
+// StealPool task: rows first .. last-1 of G(n, p), one stream per row
+static void erdosRenyiRows(void *ctx, int t) {
+    GenJob *job = (GenJob *)ctx;
+    GenTask *task = &job->tasks[t];
+    int n = job->n;
+
+    // the gap to the next edge among the n-1 other vertices is geometric
+    double logq = log1p(-job->p);
+    task->capacity = (long)((task->last - task->first) * (n - 1.0) * job->p * 1.1) + 16;
+    task->src = (vertex *)malloc(task->capacity * sizeof(vertex));
+    task->dst = (vertex *)malloc(task->capacity * sizeof(vertex));
+    if (!task->src || !task->dst) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+
+    for (long u = task->first; u < task->last; u++) {
+        CounterRng rng = rngStream(job->seed, u);
+        long v = -1;
+        while (1) {
+            double skip = (job->p >= 1.0) ? 0.0 : floor(log1p(-rngUniform(&rng)) / logq);
+            if (skip >= (double)(n - 1) - v - 1) break;
+            v += 1 + (long)skip;
+            pushEdge(task, (vertex)u, (vertex)(v < u ? v : v + 1));
+        }
+    }
+}
+
+// StealPool task: copy task t's edges to their place in the list
+static void gatherTask(void *ctx, int t) {
+    GenJob *job = (GenJob *)ctx;
+    GenTask *task = &job->tasks[t];
+    memcpy(job->edges->src + job->firstEdge[t], task->src, task->count * sizeof(vertex));
+    memcpy(job->edges->dst + job->firstEdge[t], task->dst, task->count * sizeof(vertex));
+}
+
+EdgeList *generateErdosRenyi(int n, long m, uint64_t seed, int threads) {
+    threads = defaultThreads(threads);
+    double p = (n > 1) ? (double)m / ((double)n * (n - 1)) : 0.0;
+    if (p <= 0.0) return allocEdgeList(n, 0);
+
+    int count = threads * GEN_TASKS_PER_THREAD;
+    if (count > n) count = n;
+    GenJob job;
+    memset(&job, 0, sizeof(job));
+    job.tasks = splitTasks(n, count);
+    job.seed = seed;
+    job.n = n;
+    job.p = p > 1.0 ? 1.0 : p;
+
+    StealPool *pool = createStealPool(threads, count);
+    runTasks(pool, count, erdosRenyiRows, &job);
+
+    // rows are concatenated in order, so the list doesn't depend on the split
+    long total = 0;
+    job.firstEdge = (long *)malloc(count * sizeof(long));
+    for (int t = 0; t < count; t++) {
+        job.firstEdge[t] = total;
+        total += job.tasks[t].count;
+    }
+    job.edges = allocEdgeList(n, total);
+    runTasks(pool, count, gatherTask, &job);
+    destroyStealPool(pool);
+
+    for (int t = 0; t < count; t++) {
+        free(job.tasks[t].src);
+        free(job.tasks[t].dst);
+    }
+    free(job.tasks);
+    free(job.firstEdge);
+    return job.edges;
+}
+
+// StealPool task: edges first .. last-1 of the R-MAT graph, one stream per edge
+static void rmatEdges(void *ctx, int t) {
+    GenJob *job = (GenJob *)ctx;
+    GenTask *task = &job->tasks[t];
+    // quadrants are picked with 16 bit uniforms, four out of every draw
+    uint64_t a = (uint64_t)(job->a * 65536), ab = (uint64_t)((job->a + job->b) * 65536);
+    uint64_t abc = (uint64_t)((job->a + job->b + job->c) * 65536);
+
+    for (long e = task->first; e < task->last; e++) {
+        CounterRng rng = rngStream(job->seed, e);
+        long s, d;
+        do {
+            s = 0;
+            d = 0;
+            uint64_t bits = 0;
+            for (int level = 0; level < job->scale; level++) {
+                if ((level & 3) == 0) bits = rngNext(&rng);
+                uint64_t r = bits & 0xffff;
+                bits >>= 16;
+                s = (s << 1) | (r >= ab);
+                d = (d << 1) | ((r >= a && r < ab) || r >= abc);
+            }
+            // ids past n and self loops are drawn again from the same stream
+        } while (s >= job->n || d >= job->n || s == d);
+        job->edges->src[e] = (vertex)s;
+        job->edges->dst[e] = (vertex)d;
+    }
+}
+
+EdgeList *generateRMAT(int n, long m, double a, double b, double c, uint64_t seed, int threads) {
+    threads = defaultThreads(threads);
+    if (n < 2 || m <= 0) return allocEdgeList(n, 0);
+
+    int count = threads * GEN_TASKS_PER_THREAD;
+    if (count > m) count = (int)m;
+    GenJob job;
+    memset(&job, 0, sizeof(job));
+    job.tasks = splitTasks(m, count);
+    job.seed = seed;
+    job.n = n;
+    job.a = a;
+    job.b = b;
+    job.c = c;
+    while ((1L << job.scale) < n) job.scale++;
+    job.edges = allocEdgeList(n, m);
+
+    // every edge has its slot, no gathering needed
+    StealPool *pool = createStealPool(threads, count);
+    runTasks(pool, count, rmatEdges, &job);
+    destroyStealPool(pool);
+
+    free(job.tasks);
+    return job.edges;
+}
+
+/*
+ * Target of edge i in the copy model: the edge list is read as a sequence
+ * where slot 2i holds the source of edge i and slot 2i+1 its target, and
+ * edge i copies a uniform earlier slot. Picking a slot is picking a vertex
+ * in proportion to its degree, and a copied target is resolved the same way
+ * from that edge's own stream, so no edge waits for another thread.
+ * The first vertex's edges are not emitted, they only anchor the sequence.
+ */
+static vertex attachTarget(uint64_t seed, long i, int d) {
+    if (i < d) return 0;
+    vertex source = (vertex)(i / d);
+    CounterRng rng = rngStream(seed, i);
+    while (1) {
+        uint64_t slot = rngBelow(&rng, 2 * (uint64_t)i);
+        vertex target = (slot & 1) ? attachTarget(seed, (long)(slot >> 1), d) : (vertex)((slot >> 1) / d);
+        if (target != source) return target;
+    }
+}
+
+// StealPool task: edges first .. last-1 of the Barabasi-Albert graph
+static void attachEdges(void *ctx, int t) {
+    GenJob *job = (GenJob *)ctx;
+    GenTask *task = &job->tasks[t];
+    for (long e = task->first; e < task->last; e++) {
+        long i = e + job->d;
+        job->edges->src[e] = (vertex)(i / job->d);
+        job->edges->dst[e] = attachTarget(job->seed, i, job->d);
+    }
+}
+
+EdgeList *generateBarabasiAlbert(int n, int d, uint64_t seed, int threads) {
+    threads = defaultThreads(threads);
+    if (n < 2 || d <= 0) return allocEdgeList(n, 0);
+    long m = (long)(n - 1) * d;
+
+    int count = threads * GEN_TASKS_PER_THREAD;
+    if (count > m) count = (int)m;
+    GenJob job;
+    memset(&job, 0, sizeof(job));
+    job.tasks = splitTasks(m, count);
+    job.seed = seed;
+    job.n = n;
+    job.d = d;
+    job.edges = allocEdgeList(n, m);
+
+    StealPool *pool = createStealPool(threads, count);
+    runTasks(pool, count, attachEdges, &job);
+    destroyStealPool(pool);
+
+    free(job.tasks);
+    return job.edges;
+}
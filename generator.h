@@ -0,0 +1,32 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <stdint.h>
+#include "loader.h"
+
+// Graph500 quadrant probabilities, d = 1 - a - b - c
+#define RMAT_A 0.57
+#define RMAT_B 0.19
+#define RMAT_C 0.19
+
+#define GEN_TASKS_PER_THREAD 4
+
+/*
+ * Synthetic graphs built on a StealPool. Random numbers come from a counter
+ * based generator: value k of stream s is a hash of (seed, s, k), and every
+ * row, edge or vertex draws from its own stream. Which thread generates
+ * which part doesn't matter, so a seed gives the same EdgeList for any
+ * thread count. Pass the result to edgeListToGraph or edgeListToCSR.
+ * threads <= 0 uses every online CPU. None of them emit self loops.
+ */
+
+// directed G(n, p) with p = m / (n (n - 1)), O(n + m) by skipping geometric gaps
+EdgeList * generateErdosRenyi(int n, long m, uint64_t seed, int threads);
+
+// m edges dropped recursively into quadrants with probabilities a, b, c, 1-a-b-c
+EdgeList * generateRMAT(int n, long m, double a, double b, double c, uint64_t seed, int threads);
+
+// preferential attachment, every vertex after the first links to d earlier ones
+EdgeList * generateBarabasiAlbert(int n, int d, uint64_t seed, int threads);
+
+#endif
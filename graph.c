@@ -1,29 +1,5 @@
-#ifndef GRAPH_H
-#define GRAPH_H
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <pthread.h>
-
-typedef int vertex;
-typedef pthread_mutex_t mutex;
-
-struct node {
-    vertex v;
-    struct node *next;
-};
-
-typedef struct node node;
-
-struct Graph {
-    unsigned int numVertices;
-    node **adjacencyListsOut;   
-    int* adjacencyListsOutLength;
-    node **adjacencyListsIn;
-    int* adjacencyListsInLength;
-};
-
-typedef struct Graph Graph;
+#include <sys/mman.h>
+#include "graph.h"
 
 // Function to create a node
 node *createNode(vertex v) {
@@ -71,22 +47,273 @@ Graph *createGraph(int vertices) {
         graph->adjacencyListsIn[i] = NULL;
     }
 
+    graph->arena = NULL;
+
+    return graph;
+}
+
+Graph *createArenaGraph(int vertices) {
+    Graph *graph = createGraph(vertices);
+    graph->arena = (NodeArena *)calloc(1, sizeof(NodeArena));
+    if (!graph->arena) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
     return graph;
 }
 
+// takes a removed node, or one from the current slab, opening a new one when it is full
+node *arenaNode(NodeArena *arena, vertex v) {
+    if (arena->freeNodes != NULL) {
+        node *reused = arena->freeNodes;
+        arena->freeNodes = reused->next;
+        arena->nodeCount++;
+        reused->v = v;
+        reused->next = NULL;
+        return reused;
+    }
+    NodeSlab *slab = arena->slabs;
+    if (slab == NULL || slab->used == ARENA_SLAB_NODES) {
+        slab = (NodeSlab *)malloc(sizeof(NodeSlab));
+        if (!slab) {
+            printf("Memory allocation failed\n");
+            exit(1);
+        }
+        slab->used = 0;
+        slab->next = arena->slabs;
+        arena->slabs = slab;
+        arena->slabCount++;
+    }
+    node *newNode = &slab->nodes[slab->used++];
+    arena->nodeCount++;
+    newNode->v = v;
+    newNode->next = NULL;
+    return newNode;
+}
+
 void addEdge(Graph *graph, vertex source, vertex destination) {
     // Outbound edge
-    node *newNodeOut = createNode(destination);
+    node *newNodeOut = graph->arena ? arenaNode(graph->arena, destination) : createNode(destination);
     newNodeOut->next = graph->adjacencyListsOut[source];
     graph->adjacencyListsOut[source] = newNodeOut;
     graph->adjacencyListsOutLength[source]++;
 
     // Inbound edge
-    node *newNodeIn = createNode(source);
+    node *newNodeIn = graph->arena ? arenaNode(graph->arena, source) : createNode(source);
     newNodeIn->next = graph->adjacencyListsIn[destination];
     graph->adjacencyListsIn[destination] = newNodeIn;
     graph->adjacencyListsInLength[destination]++;
 }
 
+// unlinks the first node holding v from list, NULL when there is none
+static node *unlinkNode(node **list, vertex v) {
+    for (node **link = list; *link != NULL; link = &(*link)->next) {
+        if ((*link)->v == v) {
+            node *found = *link;
+            *link = found->next;
+            return found;
+        }
+    }
+    return NULL;
+}
+
+static void releaseNode(Graph *graph, node *n) {
+    if (graph->arena) {
+        n->next = graph->arena->freeNodes;
+        graph->arena->freeNodes = n;
+        graph->arena->nodeCount--;
+    } else {
+        free(n);
+    }
+}
+
+int removeEdge(Graph *graph, vertex source, vertex destination) {
+    node *out = unlinkNode(&graph->adjacencyListsOut[source], destination);
+    if (out == NULL) return 0;
+    releaseNode(graph, out);
+    graph->adjacencyListsOutLength[source]--;
+
+    // every out node has its in node, duplicates of the edge pair up in any order
+    releaseNode(graph, unlinkNode(&graph->adjacencyListsIn[destination], source));
+    graph->adjacencyListsInLength[destination]--;
+    return 1;
+}
+
+void freeGraph(Graph *graph) {
+    if (!graph) return;
+
+    if (graph->arena) {
+        // one free per slab instead of one per node
+        NodeSlab *slab = graph->arena->slabs;
+        while (slab != NULL) {
+            NodeSlab *temp = slab;
+            slab = slab->next;
+            free(temp);
+        }
+        free(graph->arena);
+    } else {
+        for (unsigned int i = 0; i < graph->numVertices; i++) {
+            node *adjList = graph->adjacencyListsOut[i];
+            while (adjList != NULL) {
+                node *temp = adjList;
+                adjList = adjList->next;
+                free(temp);
+            }
+
+            adjList = graph->adjacencyListsIn[i];
+            while (adjList != NULL) {
+                node *temp = adjList;
+                adjList = adjList->next;
+                free(temp);
+            }
+        }
+    }
+
+    free(graph->adjacencyListsOut);
+    free(graph->adjacencyListsIn);
+    free(graph->adjacencyListsOutLength);
+    free(graph->adjacencyListsInLength);
+    free(graph);
+}
+
+void getGraphAllocStats(Graph *graph, GraphAllocStats *stats) {
+    if (graph->arena) {
+        stats->nodes = graph->arena->nodeCount;
+        stats->slabs = graph->arena->slabCount;
+        stats->bytesReserved = (size_t)stats->slabs * sizeof(NodeSlab);
+    } else {
+        // every edge is one node in each direction
+        long edges = 0;
+        for (unsigned int i = 0; i < graph->numVertices; i++) {
+            edges += graph->adjacencyListsOutLength[i];
+        }
+        stats->nodes = 2 * edges;
+        stats->slabs = 0;
+        stats->bytesReserved = (size_t)stats->nodes * sizeof(node);
+    }
+    stats->bytesUsed = (size_t)stats->nodes * sizeof(node);
+}
+
+CSRGraph *createCSRGraph(Graph *graph) {
+    CSRGraph *csr = (CSRGraph *)malloc(sizeof(CSRGraph));
+    if (!csr) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    int n = graph->numVertices;
+    csr->numVertices = n;
+
+    csr->inOffsets  = (long *)malloc((n + 1) * sizeof(long));
+    csr->outOffsets = (long *)malloc((n + 1) * sizeof(long));
+    csr->outDegree  = (int *)malloc(n * sizeof(int));
+    if (!csr->inOffsets || !csr->outOffsets || !csr->outDegree) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+
+    // prefix sums of the lengths give the offsets
+    csr->inOffsets[0] = 0;
+    csr->outOffsets[0] = 0;
+    for (int i = 0; i < n; i++) {
+        csr->inOffsets[i + 1]  = csr->inOffsets[i]  + graph->adjacencyListsInLength[i];
+        csr->outOffsets[i + 1] = csr->outOffsets[i] + graph->adjacencyListsOutLength[i];
+        csr->outDegree[i] = graph->adjacencyListsOutLength[i];
+    }
+    csr->numEdges = csr->inOffsets[n];
+    csr->mapping = NULL;
+    csr->mappingSize = 0;
+
+    // +1 so an edgeless graph still gets a valid pointer
+    csr->inNeighbors  = (vertex *)malloc((csr->numEdges + 1) * sizeof(vertex));
+    csr->outNeighbors = (vertex *)malloc((csr->numEdges + 1) * sizeof(vertex));
+    if (!csr->inNeighbors || !csr->outNeighbors) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+
+    for (int i = 0; i < n; i++) {
+        long k = csr->inOffsets[i];
+        for (node *u = graph->adjacencyListsIn[i]; u != NULL; u = u->next) {
+            csr->inNeighbors[k++] = u->v;
+        }
+        k = csr->outOffsets[i];
+        for (node *u = graph->adjacencyListsOut[i]; u != NULL; u = u->next) {
+            csr->outNeighbors[k++] = u->v;
+        }
+    }
+
+    return csr;
+}
+
+void freeCSRGraph(CSRGraph *csr) {
+    if (!csr) return;
+    if (csr->mapping) {
+        munmap(csr->mapping, csr->mappingSize);
+        free(csr);
+        return;
+    }
+    free(csr->inOffsets);
+    free(csr->inNeighbors);
+    free(csr->outOffsets);
+    free(csr->outNeighbors);
+    free(csr->outDegree);
+    free(csr);
+}
+
+void partitionByInEdges(Graph *graph, CSRGraph *csr, int parts, int *bounds) {
+    int n = csr ? (int)csr->numVertices : (int)graph->numVertices;
 
-#endif
+    // work[i] = in-edges of vertices before i, plus i
+    long *work = (long *)malloc((n + 1) * sizeof(long));
+    if (!work) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    work[0] = 0;
+    for (int i = 0; i < n; i++) {
+        long in = csr ? csr->inOffsets[i + 1] - csr->inOffsets[i] : graph->adjacencyListsInLength[i];
+        work[i + 1] = work[i] + in + 1;
+    }
+
+    bounds[0] = 0;
+    int v = 0;
+    for (int p = 1; p < parts; p++) {
+        long target = work[n] * p / parts;
+        // work is increasing, so each bound continues where the last stopped
+        while (v < n && work[v] < target) v++;
+        bounds[p] = v;
+    }
+    bounds[parts] = n;
+
+    free(work);
+}
+
+int *danglingList(int *outLength, int n, int *count) {
+    int c = 0;
+    for (int i = 0; i < n; i++) {
+        if (outLength[i] == 0) c++;
+    }
+
+    // +1 so a graph without dangling vertices still gets a valid pointer
+    int *list = (int *)malloc((c + 1) * sizeof(int));
+    if (!list) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    c = 0;
+    for (int i = 0; i < n; i++) {
+        if (outLength[i] == 0) list[c++] = i;
+    }
+    *count = c;
+    return list;
+}
+
+int danglingLowerBound(int *list, int count, vertex v) {
+    int lo = 0, hi = count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (list[mid] < v) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
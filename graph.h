@@ -15,16 +15,72 @@ struct node {
 
 typedef struct node node;
 
+// nodes per slab, 1MB with 16 byte nodes
+#define ARENA_SLAB_NODES (1 << 16)
+
+/*
+ * Slab arena for nodes: addEdge takes the next free node out of the current
+ * slab instead of calling malloc, and freeGraph releases slabs, not nodes.
+ * removeEdge can't give a node back to its slab, it goes on freeNodes and
+ * the next addEdge takes it from there first.
+ */
+struct NodeSlab {
+    struct NodeSlab *next;
+    int used;
+    node nodes[ARENA_SLAB_NODES];
+};
+
+typedef struct NodeSlab NodeSlab;
+
+struct NodeArena {
+    NodeSlab *slabs; // newest first
+    long slabCount;
+    long nodeCount;  // nodes in the lists
+    node *freeNodes; // removed nodes, linked through next
+};
+
+typedef struct NodeArena NodeArena;
+
+struct GraphAllocStats {
+    long nodes;           // nodes handed out
+    long slabs;           // 0 when the graph is not arena backed
+    size_t bytesUsed;     // nodes * sizeof(node)
+    size_t bytesReserved; // memory held for nodes
+};
+
+typedef struct GraphAllocStats GraphAllocStats;
+
 struct Graph {
     unsigned int numVertices;
     node **adjacencyListsOut;   
     int* adjacencyListsOutLength;
     node **adjacencyListsIn;
     int* adjacencyListsInLength;
+    NodeArena* arena; // NULL means one malloc per node
 };
 
 typedef struct Graph Graph;
 
+/*
+ * Compressed sparse row form of a Graph. The in-neighbors of vertex i are
+ * inNeighbors[inOffsets[i]] .. inNeighbors[inOffsets[i+1]-1], the same for
+ * the out direction, so the kernels stream over contiguous arrays instead of
+ * chasing node pointers. Built once after all addEdge calls, read only after.
+ */
+struct CSRGraph {
+    unsigned int numVertices;
+    long numEdges;
+    long* inOffsets;       // numVertices+1 entries
+    vertex* inNeighbors;   // numEdges entries
+    long* outOffsets;      // numVertices+1 entries
+    vertex* outNeighbors;  // numEdges entries
+    int* outDegree;        // same values as adjacencyListsOutLength
+    void* mapping;         // the arrays point into this file mapping, NULL when malloced
+    size_t mappingSize;
+};
+
+typedef struct CSRGraph CSRGraph;
+
 /*
  * NOTE: these functions are not safe to use in 
  * a multithreaded environment - they don't make use of mutexes.
@@ -36,6 +92,37 @@ node * createNode(vertex v);
 
 void addEdge(Graph *graph, vertex source, vertex destination);
 
+// unlinks one source -> destination edge from both lists, returns 0 when there is none
+int removeEdge(Graph *graph, vertex source, vertex destination);
+
 Graph * createGraph(int vertices);
 
+// same as createGraph, but the nodes come from a NodeArena
+Graph * createArenaGraph(int vertices);
+
+// frees the lists in both directions and the graph itself
+void freeGraph(Graph *graph);
+
+void getGraphAllocStats(Graph *graph, GraphAllocStats *stats);
+
+/*
+ * Splits the vertices 0..N-1 into parts ranges carrying about the same number
+ * of in-edges (counting one extra per vertex for its own update), so a range
+ * holding the hubs gets fewer vertices. Part p is bounds[p] .. bounds[p+1]-1,
+ * bounds needs parts+1 entries. Uses csr when given, graph otherwise.
+ */
+void partitionByInEdges(Graph *graph, CSRGraph *csr, int parts, int *bounds);
+
+// sorted ids of the vertices without outlinks, their count goes to *count
+int * danglingList(int *outLength, int n, int *count);
+
+// first index in the sorted list at or after vertex v
+int danglingLowerBound(int *list, int count, vertex v);
+
+// neighbors keep the linked list order so sums match the list kernels
+CSRGraph * createCSRGraph(Graph *graph);
+
+// unmaps a mapped graph instead of freeing its arrays
+void freeCSRGraph(CSRGraph *csr);
+
 #endif
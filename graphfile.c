@@ -0,0 +1,210 @@
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "graphfile.h"
+
+#define BYTE_ORDER_MARK 0x01020304u
+#define CHECKSUM_PRIME  0x100000001b3ULL
+
+_Static_assert(sizeof(GraphFileHeader) == 128, "graph file header must stay 128 bytes");
+_Static_assert(sizeof(long) == 8, "graph files store offsets as 64 bit longs");
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+// four independent lanes so the multiplies overlap, memory bound on big graphs
+uint64_t checksumBytes(uint64_t seed, const void *data, size_t len) {
+    const unsigned char *p = (const unsigned char *)data;
+    uint64_t lane[4] = {seed, seed ^ 1, seed ^ 2, seed ^ 3};
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        for (int k = 0; k < 4; k++) {
+            uint64_t w;
+            memcpy(&w, p + i + 8 * k, 8);
+            lane[k] = rotl64((lane[k] ^ w) * CHECKSUM_PRIME, 29);
+        }
+    }
+    uint64_t h = lane[0] ^ rotl64(lane[1], 16) ^ rotl64(lane[2], 32) ^ rotl64(lane[3], 48);
+    for (; i < len; i++) {
+        h = (h ^ p[i]) * CHECKSUM_PRIME;
+    }
+    return (h ^ len) * CHECKSUM_PRIME;
+}
+
+static uint64_t checksumCSR(CSRGraph *csr) {
+    size_t n = csr->numVertices, m = csr->numEdges;
+    uint64_t h = checksumBytes(0, csr->inOffsets, (n + 1) * sizeof(long));
+    h = checksumBytes(h, csr->outOffsets, (n + 1) * sizeof(long));
+    h = checksumBytes(h, csr->inNeighbors, m * sizeof(vertex));
+    h = checksumBytes(h, csr->outNeighbors, m * sizeof(vertex));
+    return checksumBytes(h, csr->outDegree, n * sizeof(int));
+}
+
+// offsets that never step back, degrees that match them and neighbors that
+// are vertices, one sequential pass so a crafted file can't send the kernels
+// out of bounds the way a matching checksum alone would let it
+static const char *structureError(CSRGraph *csr) {
+    unsigned int n = csr->numVertices;
+    for (unsigned int i = 0; i < n; i++) {
+        if (csr->inOffsets[i] > csr->inOffsets[i + 1] || csr->outOffsets[i] > csr->outOffsets[i + 1]) {
+            return "offsets out of order";
+        }
+        if (csr->outDegree[i] != csr->outOffsets[i + 1] - csr->outOffsets[i]) {
+            return "out-degrees don't match the offsets";
+        }
+    }
+    for (long e = 0; e < csr->numEdges; e++) {
+        if (csr->inNeighbors[e] >= n || csr->outNeighbors[e] >= n) return "neighbor outside of the graph";
+    }
+    return NULL;
+}
+
+static uint64_t alignUp(uint64_t pos) {
+    return (pos + GRAPH_FILE_ALIGN - 1) & ~(uint64_t)(GRAPH_FILE_ALIGN - 1);
+}
+
+// pads the file up to offset, then writes bytes of data
+static int writeSection(FILE *f, uint64_t *pos, uint64_t offset, const void *data, size_t bytes) {
+    static const char zeros[GRAPH_FILE_ALIGN];
+    if (offset > *pos && fwrite(zeros, 1, offset - *pos, f) != offset - *pos) return -1;
+    if (bytes > 0 && fwrite(data, 1, bytes, f) != bytes) return -1;
+    *pos = offset + bytes;
+    return 0;
+}
+
+int writeCSRGraphFile(const char *path, CSRGraph *csr) {
+    size_t n = csr->numVertices, m = csr->numEdges;
+
+    GraphFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, GRAPH_FILE_MAGIC, sizeof(header.magic));
+    header.version = GRAPH_FILE_VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.numVertices = n;
+    header.numEdges = m;
+    header.inOffsets = alignUp(sizeof(header));
+    header.outOffsets = alignUp(header.inOffsets + (n + 1) * sizeof(long));
+    header.inNeighbors = alignUp(header.outOffsets + (n + 1) * sizeof(long));
+    header.outNeighbors = alignUp(header.inNeighbors + m * sizeof(vertex));
+    header.outDegree = alignUp(header.outNeighbors + m * sizeof(vertex));
+    header.fileSize = header.outDegree + n * sizeof(int);
+    header.checksum = checksumCSR(csr);
+
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    uint64_t pos = 0;
+    int failed = writeSection(f, &pos, 0, &header, sizeof(header)) ||
+                 writeSection(f, &pos, header.inOffsets, csr->inOffsets, (n + 1) * sizeof(long)) ||
+                 writeSection(f, &pos, header.outOffsets, csr->outOffsets, (n + 1) * sizeof(long)) ||
+                 writeSection(f, &pos, header.inNeighbors, csr->inNeighbors, m * sizeof(vertex)) ||
+                 writeSection(f, &pos, header.outNeighbors, csr->outNeighbors, m * sizeof(vertex)) ||
+                 writeSection(f, &pos, header.outDegree, csr->outDegree, n * sizeof(int));
+    if (fclose(f) != 0) failed = 1;
+    if (failed) {
+        perror(path);
+        return -1;
+    }
+    return 0;
+}
+
+int writeGraphFile(const char *path, Graph *graph) {
+    CSRGraph *csr = createCSRGraph(graph);
+    int result = writeCSRGraphFile(path, csr);
+    freeCSRGraph(csr);
+    return result;
+}
+
+// a section has to lie inside the file and start aligned
+static int sectionOk(GraphFileHeader *h, uint64_t offset, uint64_t bytes) {
+    return offset % GRAPH_FILE_ALIGN == 0 && offset >= sizeof(GraphFileHeader) &&
+           offset <= h->fileSize && bytes <= h->fileSize - offset;
+}
+
+CSRGraph *mapCSRGraphFile(const char *path, int flags) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        perror(path);
+        close(fd);
+        return NULL;
+    }
+    size_t size = st.st_size;
+    if (size < sizeof(GraphFileHeader)) {
+        fprintf(stderr, "%s: too short for a graph file\n", path);
+        close(fd);
+        return NULL;
+    }
+
+    // shared, so every job on the same graph uses the same page cache pages
+    void *data = mmap(NULL, size, PROT_READ, MAP_SHARED | ((flags & GRAPH_MAP_POPULATE) ? MAP_POPULATE : 0), fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        perror(path);
+        return NULL;
+    }
+    if (flags & GRAPH_MAP_WILLNEED) madvise(data, size, MADV_WILLNEED);
+
+    GraphFileHeader *h = (GraphFileHeader *)data;
+    uint64_t n = h->numVertices, m = h->numEdges;
+    const char *error = NULL;
+    if (memcmp(h->magic, GRAPH_FILE_MAGIC, sizeof(h->magic)) != 0) {
+        error = "not a graph file";
+    } else if (h->byteOrder != BYTE_ORDER_MARK) {
+        error = "written with a different byte order";
+    } else if (h->version != GRAPH_FILE_VERSION) {
+        error = "unsupported graph file version";
+    } else if (h->fileSize != size || n >= (1u << 31) || m >= (1ULL << 60)) {
+        error = "truncated or corrupt header";
+    } else if (!sectionOk(h, h->inOffsets, (n + 1) * sizeof(long)) ||
+               !sectionOk(h, h->outOffsets, (n + 1) * sizeof(long)) ||
+               !sectionOk(h, h->inNeighbors, m * sizeof(vertex)) ||
+               !sectionOk(h, h->outNeighbors, m * sizeof(vertex)) ||
+               !sectionOk(h, h->outDegree, n * sizeof(int))) {
+        error = "section outside of the file";
+    }
+
+    CSRGraph *csr = NULL;
+    if (error == NULL) {
+        csr = (CSRGraph *)malloc(sizeof(CSRGraph));
+        if (!csr) {
+            printf("Memory allocation failed\n");
+            exit(1);
+        }
+        char *base = (char *)data;
+        csr->numVertices = (unsigned int)n;
+        csr->numEdges = (long)m;
+        csr->inOffsets = (long *)(base + h->inOffsets);
+        csr->outOffsets = (long *)(base + h->outOffsets);
+        csr->inNeighbors = (vertex *)(base + h->inNeighbors);
+        csr->outNeighbors = (vertex *)(base + h->outNeighbors);
+        csr->outDegree = (int *)(base + h->outDegree);
+        csr->mapping = data;
+        csr->mappingSize = size;
+
+        // cheap enough to always check, the kernels index with these
+        if (csr->inOffsets[0] != 0 || csr->inOffsets[n] != (long)m ||
+            csr->outOffsets[0] != 0 || csr->outOffsets[n] != (long)m) {
+            error = "offsets don't match the edge count";
+        } else if (flags & GRAPH_MAP_VERIFY) {
+            error = checksumCSR(csr) != h->checksum ? "checksum mismatch" : structureError(csr);
+        }
+    }
+
+    if (error != NULL) {
+        fprintf(stderr, "%s: %s\n", path, error);
+        free(csr);
+        munmap(data, size);
+        return NULL;
+    }
+    return csr;
+}
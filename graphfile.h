@@ -0,0 +1,58 @@
+#ifndef GRAPHFILE_H
+#define GRAPHFILE_H
+
+#include <stdint.h>
+#include "graph.h"
+
+#define GRAPH_FILE_MAGIC   "PRGRAPH" // 8 bytes with the terminator
+#define GRAPH_FILE_VERSION 1
+#define GRAPH_FILE_ALIGN   64        // every section starts on a cache line
+
+#define GRAPH_MAP_POPULATE 1 // MAP_POPULATE, fault the whole file in before returning
+#define GRAPH_MAP_WILLNEED 2 // MADV_WILLNEED, read ahead in the background
+#define GRAPH_MAP_VERIFY   4 // compare the checksum and check offsets and neighbors, touches every page
+
+/*
+ * On-disk form of a CSRGraph: a header followed by the five arrays exactly
+ * as they sit in memory. mapCSRGraphFile points a CSRGraph into a read only
+ * mapping of the file, so a graph already in the page cache is ready without
+ * reading, parsing or copying anything. Native byte order and 64 bit longs,
+ * the header records both and the reader refuses anything else.
+ *
+ * Without GRAPH_MAP_VERIFY only the header, the section bounds and the first
+ * and last offsets are checked, the rest of the file is trusted: offsets out
+ * of order or neighbor ids past numVertices make the kernels read out of
+ * bounds. Map files that didn't come from writeCSRGraphFile with the flag.
+ */
+struct GraphFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;    // 0x01020304 as the writer stored it
+    uint64_t numVertices;
+    uint64_t numEdges;
+    uint64_t fileSize;
+    uint64_t checksum;     // of the sections, in the order below
+    // byte offsets of the sections from the start of the file
+    uint64_t inOffsets;    // numVertices+1 longs
+    uint64_t outOffsets;   // numVertices+1 longs
+    uint64_t inNeighbors;  // numEdges vertices
+    uint64_t outNeighbors; // numEdges vertices
+    uint64_t outDegree;    // numVertices ints
+    char pad[40];          // header is 128 bytes
+};
+
+typedef struct GraphFileHeader GraphFileHeader;
+
+// hash of len bytes chained from seed, checkpoint files use it too
+uint64_t checksumBytes(uint64_t seed, const void *data, size_t len);
+
+// returns 0, or -1 after printing why the file couldn't be written
+int writeCSRGraphFile(const char *path, CSRGraph *csr);
+
+// builds the CSR form of graph and writes that
+int writeGraphFile(const char *path, Graph *graph);
+
+// flags is a mix of GRAPH_MAP_*, returns NULL after printing why on failure
+CSRGraph * mapCSRGraphFile(const char *path, int flags);
+
+#endif
@@ -0,0 +1,78 @@
+#include "latch.h"
+
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <limits.h>
+#endif
+
+static inline void cpuRelax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+void initLatch(Latch* latch) {
+    atomic_init(&latch->count, 0);
+    atomic_init(&latch->parked, 0);
+    latch->spin = (sysconf(_SC_NPROCESSORS_ONLN) > 1) ? LATCH_SPIN : 0;
+#ifndef __linux__
+    pthread_mutex_init(&latch->mutex, NULL);
+    pthread_cond_init(&latch->cond, NULL);
+#endif
+}
+
+void latchAdd(Latch* latch, int n) {
+    atomic_fetch_add(&latch->count, n);
+}
+
+void latchCountDown(Latch* latch) {
+    if (atomic_fetch_sub(&latch->count, 1) != 1) return;
+
+    // seq_cst against the waiter's parked store then count load,
+    // one of the two always sees the other
+    if (atomic_load(&latch->parked) == 0) return;
+#ifdef __linux__
+    syscall(SYS_futex, &latch->count, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#else
+    pthread_mutex_lock(&latch->mutex);
+    pthread_cond_broadcast(&latch->cond);
+    pthread_mutex_unlock(&latch->mutex);
+#endif
+}
+
+void latchWait(Latch* latch) {
+    for (int i = 0; i < latch->spin; i++) {
+        if (atomic_load(&latch->count) == 0) return;
+        cpuRelax();
+    }
+
+    atomic_store(&latch->parked, 1);
+#ifdef __linux__
+    int count;
+    while ((count = atomic_load(&latch->count)) != 0) {
+        // sleeps only while count still holds the value we saw
+        syscall(SYS_futex, &latch->count, FUTEX_WAIT_PRIVATE, count, NULL, NULL, 0);
+    }
+#else
+    pthread_mutex_lock(&latch->mutex);
+    while (atomic_load(&latch->count) != 0) {
+        pthread_cond_wait(&latch->cond, &latch->mutex);
+    }
+    pthread_mutex_unlock(&latch->mutex);
+#endif
+    atomic_store(&latch->parked, 0);
+}
+
+void destroyLatch(Latch* latch) {
+#ifndef __linux__
+    pthread_mutex_destroy(&latch->mutex);
+    pthread_cond_destroy(&latch->cond);
+#else
+    (void)latch;
+#endif
+}
@@ -0,0 +1,39 @@
+#ifndef LATCH_H
+#define LATCH_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+// spins before parking, a block of a few hundred vertices finishes within that.
+// on a single cpu spinning only delays the workers, so it is skipped
+#define LATCH_SPIN 4000
+
+/*
+ * Countdown latch marking the end of an iteration: the submitter adds one
+ * per task, workers count down as they finish, and latchWait returns once
+ * the count is back at zero. The waiter spins for a while and then parks,
+ * on a futex on linux and a condition variable elsewhere. The last count
+ * down only makes a syscall when the waiter is actually parked.
+ */
+typedef struct Latch {
+    atomic_int count;
+    atomic_int parked; // the waiter is asleep or about to be
+    int spin;          // LATCH_SPIN, or 0 on one cpu
+#ifndef __linux__
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+#endif
+} Latch;
+
+void initLatch(Latch* latch);
+
+void latchAdd(Latch* latch, int n);
+
+void latchCountDown(Latch* latch);
+
+// returns once the count is 0, all writes made before each count down are visible
+void latchWait(Latch* latch);
+
+void destroyLatch(Latch* latch);
+
+#endif
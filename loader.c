@@ -0,0 +1,437 @@
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "loader.h"
+#include "graphfile.h"
+#include "steal.h"
+#include "bench.h"
+
+// one per chunk, written only by the task parsing it
+typedef struct ParseChunk {
+    const char* begin;
+    const char* end;
+    vertex* src;
+    vertex* dst;
+    long count;
+    long capacity;
+    long entries;     // lines holding an edge, before symmetric expansion
+    long maxId;
+    long errorOffset; // -1, or where the first malformed line starts
+} ParseChunk;
+
+typedef struct ParseJob {
+    const char* data;
+    ParseChunk* chunks;
+    int base;       // subtracted from every id, 1 for .mtx
+    int symmetric;  // add j -> i for every off-diagonal i -> j
+    EdgeList* edges;
+    long* firstEdge; // where each chunk's edges go in edges
+} ParseJob;
+
+int graphFormat(const char *path) {
+    char magic[sizeof(GRAPH_FILE_MAGIC)];
+    int fd = open(path, O_RDONLY);
+    if (fd >= 0) {
+        ssize_t got = read(fd, magic, sizeof(magic));
+        close(fd);
+        if (got == (ssize_t)sizeof(magic) && memcmp(magic, GRAPH_FILE_MAGIC, sizeof(magic)) == 0) {
+            return FORMAT_GRAPH_FILE;
+        }
+    }
+    size_t len = strlen(path);
+    return (len >= 4 && strcmp(path + len - 4, ".mtx") == 0) ? FORMAT_MATRIX_MARKET : FORMAT_EDGE_LIST;
+}
+
+static void setMapStats(LoadStats *stats, CSRGraph *csr, double start) {
+    stats->bytes = csr->mappingSize;
+    stats->edges = csr->numEdges;
+    stats->vertices = csr->numVertices;
+    stats->threads = 1;
+    stats->parseTime = wallTime() - start;
+    stats->buildTime = 0.0;
+}
+
+// the out-lists of a mapped graph file, each source's reversed so that
+// edgeListToCSR, which fills them back to front, gives them back in file order
+static EdgeList *mapGraphFileEdges(const char *path, LoadStats *stats) {
+    double start = wallTime();
+    CSRGraph *csr = mapCSRGraphFile(path, GRAPH_MAP_WILLNEED | GRAPH_MAP_VERIFY);
+    if (!csr) return NULL;
+
+    EdgeList *edges = (EdgeList *)malloc(sizeof(EdgeList));
+    if (!edges) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    long m = csr->numEdges;
+    edges->numVertices = csr->numVertices;
+    edges->numEdges = m;
+    edges->src = (vertex *)malloc((m + 1) * sizeof(vertex));
+    edges->dst = (vertex *)malloc((m + 1) * sizeof(vertex));
+    if (!edges->src || !edges->dst) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    long e = 0;
+    for (unsigned int s = 0; s < csr->numVertices; s++) {
+        for (long k = csr->outOffsets[s + 1] - 1; k >= csr->outOffsets[s]; k--) {
+            edges->src[e] = s;
+            edges->dst[e++] = csr->outNeighbors[k];
+        }
+    }
+
+    if (stats) setMapStats(stats, csr, start);
+    freeCSRGraph(csr);
+    return edges;
+}
+
+static const char *parseId(const char *p, const char *end, long *id) {
+    if (p == end || *p < '0' || *p > '9') return NULL;
+    long v = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        v = v * 10 + (*p - '0');
+        if (v > INT_MAX) return NULL;
+        p++;
+    }
+    *id = v;
+    return p;
+}
+
+static void pushEdge(ParseChunk *chunk, vertex s, vertex d) {
+    if (chunk->count == chunk->capacity) {
+        chunk->capacity *= 2;
+        chunk->src = (vertex *)realloc(chunk->src, chunk->capacity * sizeof(vertex));
+        chunk->dst = (vertex *)realloc(chunk->dst, chunk->capacity * sizeof(vertex));
+        if (!chunk->src || !chunk->dst) {
+            printf("Memory allocation failed\n");
+            exit(1);
+        }
+    }
+    chunk->src[chunk->count] = s;
+    chunk->dst[chunk->count] = d;
+    chunk->count++;
+}
+
+// StealPool task: parse the lines of chunk t
+static void parseChunk(void *ctx, int t) {
+    ParseJob *job = (ParseJob *)ctx;
+    ParseChunk *chunk = &job->chunks[t];
+    const char *p = chunk->begin, *end = chunk->end;
+
+    // shortest line is "0 1\n"
+    chunk->capacity = (end - p) / 8 + 16;
+    chunk->src = (vertex *)malloc(chunk->capacity * sizeof(vertex));
+    chunk->dst = (vertex *)malloc(chunk->capacity * sizeof(vertex));
+    if (!chunk->src || !chunk->dst) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+
+    while (p < end) {
+        const char *line = p;
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+        if (p == end) break;
+
+        if (*p != '\n' && *p != '#' && *p != '%') {
+            long a, b;
+            p = parseId(p, end, &a);
+            if (p == NULL || p == end || (*p != ' ' && *p != '\t')) {
+                chunk->errorOffset = line - job->data;
+                return;
+            }
+            while (p < end && (*p == ' ' || *p == '\t')) p++;
+            p = parseId(p, end, &b);
+            // "1 2abc" or "1 2.5" is a typo, not the edge 1 -> 2
+            if (p == NULL || (p != end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') ||
+                a < job->base || b < job->base) {
+                chunk->errorOffset = line - job->data;
+                return;
+            }
+            a -= job->base;
+            b -= job->base;
+
+            pushEdge(chunk, (vertex)a, (vertex)b);
+            if (job->symmetric && a != b) pushEdge(chunk, (vertex)b, (vertex)a);
+            chunk->entries++;
+            if (a > chunk->maxId) chunk->maxId = a;
+            if (b > chunk->maxId) chunk->maxId = b;
+        }
+
+        // the rest of the line is a weight or a comment
+        while (p < end && *p != '\n') p++;
+        if (p < end) p++;
+    }
+}
+
+// StealPool task: copy chunk t's edges to their place in the list
+static void gatherChunk(void *ctx, int t) {
+    ParseJob *job = (ParseJob *)ctx;
+    ParseChunk *chunk = &job->chunks[t];
+    memcpy(job->edges->src + job->firstEdge[t], chunk->src, chunk->count * sizeof(vertex));
+    memcpy(job->edges->dst + job->firstEdge[t], chunk->dst, chunk->count * sizeof(vertex));
+}
+
+/*
+ * Reads the banner and size line of a Matrix Market file. Returns the offset
+ * of the first entry line, or -1 when the file is not a coordinate matrix.
+ */
+static long parseMatrixMarketHeader(const char *data, size_t size, long *rows, long *cols,
+                                    long *nonzeros, int *symmetric) {
+    char line[256];
+    size_t pos = 0;
+    int banner = 1;
+
+    while (pos < size) {
+        size_t len = 0;
+        while (pos + len < size && data[pos + len] != '\n') len++;
+        size_t copy = len < sizeof(line) - 1 ? len : sizeof(line) - 1;
+        memcpy(line, data + pos, copy);
+        line[copy] = '\0';
+        pos += len + (pos + len < size);
+
+        if (banner) {
+            char object[32], format[32], field[32], symmetry[32];
+            if (sscanf(line, "%%%%MatrixMarket %31s %31s %31s %31s", object, format, field, symmetry) != 4 ||
+                strcmp(object, "matrix") != 0 || strcmp(format, "coordinate") != 0) {
+                return -1;
+            }
+            *symmetric = strcmp(symmetry, "general") != 0;
+            banner = 0;
+        } else if (line[0] != '%' && line[strspn(line, " \t\r")] != '\0') {
+            return sscanf(line, "%ld %ld %ld", rows, cols, nonzeros) == 3 ? (long)pos : -1;
+        }
+    }
+    return -1;
+}
+
+EdgeList *loadEdgeList(const char *path, int format, int threads, LoadStats *stats) {
+    if (format == FORMAT_GRAPH_FILE) return mapGraphFileEdges(path, stats);
+    double start = wallTime();
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        perror(path);
+        close(fd);
+        return NULL;
+    }
+    size_t size = st.st_size;
+
+    const char *data = "";
+    if (size > 0) {
+        data = (const char *)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            perror(path);
+            close(fd);
+            return NULL;
+        }
+        madvise((void *)data, size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    ParseJob job = {data, NULL, 0, 0, NULL, NULL};
+    long bodyStart = 0, rows = 0, cols = 0, nonzeros = -1;
+    if (format == FORMAT_MATRIX_MARKET) {
+        bodyStart = parseMatrixMarketHeader(data, size, &rows, &cols, &nonzeros, &job.symmetric);
+        if (bodyStart < 0) {
+            fprintf(stderr, "%s: not a coordinate Matrix Market file\n", path);
+            if (size > 0) munmap((void *)data, size);
+            return NULL;
+        }
+        job.base = 1;
+    }
+
+    if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1) threads = 1;
+    int chunks = threads * LOAD_CHUNKS_PER_THREAD;
+    if ((long)(size - bodyStart) < chunks * 4096L) chunks = 1;
+
+    // every chunk but the first starts right after a newline
+    job.chunks = (ParseChunk *)calloc(chunks, sizeof(ParseChunk));
+    const char *prev = data + bodyStart;
+    for (int c = 0; c < chunks; c++) {
+        const char *next = data + size;
+        if (c + 1 < chunks) {
+            next = data + bodyStart + (size - bodyStart) * (c + 1) / chunks;
+            while (next < data + size && next > prev && next[-1] != '\n') next++;
+            if (next < prev) next = prev;
+        }
+        job.chunks[c].begin = prev;
+        job.chunks[c].end = next;
+        job.chunks[c].maxId = -1;
+        job.chunks[c].errorOffset = -1;
+        prev = next;
+    }
+
+    StealPool *pool = createStealPool(threads, chunks);
+    runTasks(pool, chunks, parseChunk, &job);
+
+    EdgeList *edges = NULL;
+    long total = 0, entries = 0, maxId = -1, errorOffset = -1;
+    job.firstEdge = (long *)malloc(chunks * sizeof(long));
+    for (int c = 0; c < chunks; c++) {
+        if (errorOffset < 0) errorOffset = job.chunks[c].errorOffset;
+        job.firstEdge[c] = total;
+        total += job.chunks[c].count;
+        entries += job.chunks[c].entries;
+        if (job.chunks[c].maxId > maxId) maxId = job.chunks[c].maxId;
+    }
+
+    long vertices = maxId + 1;
+    if (format == FORMAT_MATRIX_MARKET) vertices = rows > cols ? rows : cols;
+
+    if (errorOffset >= 0) {
+        const char *line = data + errorOffset;
+        int len = (int)strcspn(line, "\n");
+        fprintf(stderr, "%s: malformed edge at byte %ld: \"%.*s\"\n", path, errorOffset, len > 60 ? 60 : len, line);
+    } else if (maxId >= vertices || vertices > INT_MAX) {
+        fprintf(stderr, "%s: vertex id %ld outside of %ld vertices\n", path, maxId, vertices);
+    } else if (nonzeros >= 0 && entries != nonzeros) {
+        fprintf(stderr, "%s: expected %ld entries, found %ld\n", path, nonzeros, entries);
+    } else {
+        edges = (EdgeList *)malloc(sizeof(EdgeList));
+        if (!edges) {
+            printf("Memory allocation failed\n");
+            exit(1);
+        }
+        edges->numVertices = (unsigned int)vertices;
+        edges->numEdges = total;
+        // +1 so an edgeless graph still gets a valid pointer
+        edges->src = (vertex *)malloc((total + 1) * sizeof(vertex));
+        edges->dst = (vertex *)malloc((total + 1) * sizeof(vertex));
+        if (!edges->src || !edges->dst) {
+            printf("Memory allocation failed\n");
+            exit(1);
+        }
+        job.edges = edges;
+        runTasks(pool, chunks, gatherChunk, &job);
+    }
+
+    destroyStealPool(pool);
+    for (int c = 0; c < chunks; c++) {
+        free(job.chunks[c].src);
+        free(job.chunks[c].dst);
+    }
+    free(job.chunks);
+    free(job.firstEdge);
+    if (size > 0) munmap((void *)data, size);
+
+    if (stats && edges) {
+        stats->bytes = size;
+        stats->edges = edges->numEdges;
+        stats->vertices = edges->numVertices;
+        stats->threads = threads;
+        stats->parseTime = wallTime() - start;
+        stats->buildTime = 0.0;
+    }
+    return edges;
+}
+
+void freeEdgeList(EdgeList *edges) {
+    if (!edges) return;
+    free(edges->src);
+    free(edges->dst);
+    free(edges);
+}
+
+Graph *edgeListToGraph(EdgeList *edges) {
+    Graph *graph = createArenaGraph(edges->numVertices);
+    for (long e = 0; e < edges->numEdges; e++) {
+        addEdge(graph, edges->src[e], edges->dst[e]);
+    }
+    return graph;
+}
+
+CSRGraph *edgeListToCSR(EdgeList *edges) {
+    CSRGraph *csr = (CSRGraph *)malloc(sizeof(CSRGraph));
+    if (!csr) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    int n = edges->numVertices;
+    long m = edges->numEdges;
+    csr->numVertices = n;
+    csr->numEdges = m;
+    csr->mapping = NULL;
+    csr->mappingSize = 0;
+
+    csr->inOffsets  = (long *)calloc(n + 1, sizeof(long));
+    csr->outOffsets = (long *)calloc(n + 1, sizeof(long));
+    csr->outDegree  = (int *)malloc((n + 1) * sizeof(int));
+    csr->inNeighbors  = (vertex *)malloc((m + 1) * sizeof(vertex));
+    csr->outNeighbors = (vertex *)malloc((m + 1) * sizeof(vertex));
+    if (!csr->inOffsets || !csr->outOffsets || !csr->outDegree || !csr->inNeighbors || !csr->outNeighbors) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+
+    for (long e = 0; e < m; e++) {
+        csr->outOffsets[edges->src[e] + 1]++;
+        csr->inOffsets[edges->dst[e] + 1]++;
+    }
+    for (int i = 0; i < n; i++) {
+        csr->outDegree[i] = (int)csr->outOffsets[i + 1];
+        csr->inOffsets[i + 1]  += csr->inOffsets[i];
+        csr->outOffsets[i + 1] += csr->outOffsets[i];
+    }
+
+    // filled back to front, addEdge prepends so the lists hold the newest edge first
+    long *inCursor  = (long *)malloc((n + 1) * sizeof(long));
+    long *outCursor = (long *)malloc((n + 1) * sizeof(long));
+    if (!inCursor || !outCursor) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    memcpy(inCursor, csr->inOffsets + 1, n * sizeof(long));
+    memcpy(outCursor, csr->outOffsets + 1, n * sizeof(long));
+    for (long e = 0; e < m; e++) {
+        vertex s = edges->src[e], d = edges->dst[e];
+        csr->outNeighbors[--outCursor[s]] = d;
+        csr->inNeighbors[--inCursor[d]] = s;
+    }
+    free(inCursor);
+    free(outCursor);
+
+    return csr;
+}
+
+Graph *loadGraph(const char *path, int threads, LoadStats *stats) {
+    EdgeList *edges = loadEdgeList(path, graphFormat(path), threads, stats);
+    if (!edges) return NULL;
+    double start = wallTime();
+    Graph *graph = edgeListToGraph(edges);
+    if (stats) stats->buildTime = wallTime() - start;
+    freeEdgeList(edges);
+    return graph;
+}
+
+CSRGraph *loadCSRGraph(const char *path, int threads, LoadStats *stats) {
+    int format = graphFormat(path);
+    if (format == FORMAT_GRAPH_FILE) {
+        double start = wallTime();
+        CSRGraph *csr = mapCSRGraphFile(path, GRAPH_MAP_WILLNEED | GRAPH_MAP_VERIFY);
+        if (csr && stats) setMapStats(stats, csr, start);
+        return csr;
+    }
+    EdgeList *edges = loadEdgeList(path, format, threads, stats);
+    if (!edges) return NULL;
+    double start = wallTime();
+    CSRGraph *csr = edgeListToCSR(edges);
+    if (stats) stats->buildTime = wallTime() - start;
+    freeEdgeList(edges);
+    return csr;
+}
+
+void printLoadStats(const char *path, LoadStats *stats) {
+    double mb = stats->bytes / 1e6;
+    printf("%s: %u vertices, %ld edges, %.1f MB parsed in %.3f s (%.1f MB/s, %d threads), built in %.3f s\n",
+           path, stats->vertices, stats->edges, mb, stats->parseTime,
+           stats->parseTime > 0 ? mb / stats->parseTime : 0.0, stats->threads, stats->buildTime);
+}
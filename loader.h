@@ -0,0 +1,66 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include "graph.h"
+
+#define FORMAT_EDGE_LIST     0 // SNAP style "src dst" per line, 0-based, '#' comments
+#define FORMAT_MATRIX_MARKET 1 // coordinate .mtx, 1-based, entry (i, j) is the edge i -> j
+#define FORMAT_GRAPH_FILE    2 // binary CSR of graphfile.h, mapped instead of parsed
+
+// chunks per thread, so a slow chunk doesn't hold up the others
+#define LOAD_CHUNKS_PER_THREAD 4
+
+/*
+ * Graph files are mapped and cut into chunks at line boundaries, the chunks
+ * are parsed on a StealPool and concatenated in file order, so the edges come
+ * out the same for any thread count. Building the lists or the CSR from them
+ * is a single pass on the calling thread.
+ */
+struct EdgeList {
+    unsigned int numVertices; // largest id + 1, or the .mtx size
+    long numEdges;
+    vertex* src;              // numEdges entries each, in file order
+    vertex* dst;
+};
+
+typedef struct EdgeList EdgeList;
+
+struct LoadStats {
+    size_t bytes;       // file size
+    long edges;
+    unsigned int vertices;
+    int threads;
+    double parseTime;   // seconds mapping and parsing
+    double buildTime;   // seconds building the Graph or CSRGraph
+};
+
+typedef struct LoadStats LoadStats;
+
+// FORMAT_GRAPH_FILE for files starting with GRAPH_FILE_MAGIC, whatever their name,
+// FORMAT_MATRIX_MARKET for names ending in .mtx, FORMAT_EDGE_LIST otherwise
+int graphFormat(const char *path);
+
+/*
+ * Parses path with threads workers (<= 0 uses every online CPU). Symmetric
+ * .mtx files get both directions of each off-diagonal entry. Graph files are
+ * mapped and their out-edges listed source by source. Prints the reason and
+ * returns NULL when the file can't be read or is malformed. stats may be NULL.
+ */
+EdgeList * loadEdgeList(const char *path, int format, int threads, LoadStats *stats);
+
+void freeEdgeList(EdgeList *edges);
+
+// arena backed, edges added in file order
+Graph * edgeListToGraph(EdgeList *edges);
+
+// same neighbor order as createCSRGraph(edgeListToGraph(edges)), without the lists
+CSRGraph * edgeListToCSR(EdgeList *edges);
+
+// loadEdgeList followed by the conversion, the format comes from graphFormat.
+// loadCSRGraph returns graph files as the mapping itself, nothing is copied
+Graph * loadGraph(const char *path, int threads, LoadStats *stats);
+CSRGraph * loadCSRGraph(const char *path, int threads, LoadStats *stats);
+
+void printLoadStats(const char *path, LoadStats *stats);
+
+#endif
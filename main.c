@@ -1,13 +1,108 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include "graph.h"
+#include "convergence.h"
+#include "simd.h"
+#include "steal.h"
+#include "latch.h"
+#include "barrier.h"
+#include "loader.h"
+#include "graphfile.h"
+#include "generator.h"
+#include "bench.h"
+#include "perfcount.h"
+#include "verify.h"
+#include "reorder.h"
+#include "blocked.h"
+#include "frontier.h"
+#include "checkpoint.h"
 #include <time.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <sched.h>
 
 #define D 0.15 // damping factor
-#define T 8 // thread count
+#define T 8 // default thread count, threadCount is what the parallel engines use
 // #define CACHE_LINE_SIZE_FP (int)64/sizeof(float)
 #define CACHE_LINE_SIZE_FP 16
 #define BLOCK_SIZE (10*CACHE_LINE_SIZE_FP) // cache line count
+#define TOLERANCE 1e-6 // L1 change between iterations to stop at
+#define KERNEL_DIVIDE  0 // ranks[u] / outLength[u] for every edge
+#define KERNEL_CONTRIB 1 // contrib[u] = ranks[u] * invOutDeg[u] once per vertex
+#define KERNEL_SIMD    2 // KERNEL_CONTRIB with vector gathers, csr only
+#define SIMD_TOLERANCE 1e-5 // max relative error of the vector kernels
+// widest pull kernel to use, clamped to what cpuid reports. 16 wide gathers
+// were slower than 8 wide on the random gathers of our graphs
+#define SIMD_LEVEL SIMD_AVX2
+#define BALANCE 1        // cut tasks by in-edges, 0 gives each task BLOCK_SIZE vertices
+#define REPORT_BALANCE 0 // print the edges per task and the time spent waiting on them
+#define EDGE_COST_N          1000000 // --edge-cost graph
+#define EDGE_COST_EDGES      10000000
+#define EDGE_COST_ITERATIONS 10
+#define GRAPH_FILE_BENCH "bench.graph" // written and removed by benchmarkGraphFile
+#define GRAPH_FILE_N          1000000 // --graph-file graph
+#define GRAPH_FILE_EDGES      10000000
+#define GRAPH_FILE_ITERATIONS 10
+#define SEED 1 // picks the random graphs, the same ones for any thread count
+#define POOL_TASKS  1000   // --pools blocks per round
+#define POOL_ROUNDS 100
+#define POOL_N      100000 // --pools graph the skewed blocks pull from when no file is given
+#define POOL_DEGREE 8
+#define BARRIER_ROUNDS 10000 // --barriers round trips per thread count
+#define GENERATORS_N     1000000 // --generators graphs
+#define GENERATORS_EDGES 10000000
+#define BENCH_CSV  "bench.csv"  // benchmarkVariants results, one row per variant
+#define BENCH_JSON "bench.json"
+#define SWEEP_MAX_THREADS 16   // --sweep doubles the threads from 1 up to this
+#define SWEEP_ITERATIONS  10
+#define SWEEP_REPS        3
+#define SWEEP_WEAK_N      50000 // vertices per thread in the weak scaling runs
+#define SWEEP_WEAK_DEGREE 8
+#define SWEEP_CSV "sweep.csv"
+// phases of the parallel engine counted by --perf
+#define PHASE_UPDATE   0 // gathering the in-neighbors, new ranks and residuals
+#define PHASE_DANGLING 1 // dangling mass of the block's new ranks
+#define PHASE_CONTRIB  2 // next contributions of the block
+#define PHASE_SWAP     3 // reduction of the block sums and the swap, main thread
+#define PHASES         4
+#define PERF_N         1000000 // --perf graph when no file is given
+#define PERF_DEGREE    10
+#define PERF_ITERATIONS 10
+#define REORDER_N          1000000 // --reorder graphs when no file is given
+#define REORDER_DEGREE     10
+#define REORDER_ITERATIONS 20
+#define BLOCKING_DEGREE     8  // --blocking graphs, sizes in blockingSizes
+#define BLOCKING_ITERATIONS 10
+#define BLOCKING_REPS       3
+#define ASYNC_LEAD 2 // sweeps a thread of AsyncPageRank may run ahead of the slowest
+#define GAUSS_SEIDEL_N          1000000 // --gauss-seidel graph
+#define GAUSS_SEIDEL_EDGES      10000000
+#define GAUSS_SEIDEL_ITERATIONS 100 // at most, every engine stops at TOLERANCE
+#define DELTA_CHUNK 1024 // frontier vertices per task of a sparse DeltaPageRank round
+#define DELTA_BATCH 64   // vertices a push task lists before reserving room in the next frontier
+#define DELTA_DENSE 20   // pull once the frontier and its out-edges pass numEdges / DELTA_DENSE
+#define DELTA_N      1000000 // --delta graphs when no file is given
+#define DELTA_DEGREE 10
+#define DELTA_ITERATIONS 100 // at most, every engine stops at TOLERANCE
+#define PPR_N          262144 // --personalized graph when no file is given
+#define PPR_DEGREE     10
+#define PPR_QUERIES    64 // seed sets, run in batches of every K in batchSizes
+#define PPR_SEEDS      4  // vertices per seed set
+#define PPR_ITERATIONS 20
+#define DYNAMIC_N      1000000 // --dynamic graph when no file is given
+#define DYNAMIC_DEGREE 10
+#define DYNAMIC_ITERATIONS 100 // at most for the full recomputations, they stop at TOLERANCE
+#define CHECKPOINT_FILE "ranks.checkpoint" // written and removed by benchmarkCheckpoint
+#define CHECKPOINT_N          1000000 // --checkpoint graph when no file is given
+#define CHECKPOINT_DEGREE     10
+#define CHECKPOINT_INTERVAL   5
+#define CHECKPOINT_PREEMPT    8    // iterations the first run gets before it is cut off
+#define CHECKPOINT_CHANGE     100  // edges per million redirected for the next day's graph
+#define CHECKPOINT_ITERATIONS 100
+
+int threadCount = T; // workers of the parallel engines
 
 void initializeRanks(float *ranks, int N) {
     for (int i = 0; i < N; i++) {
@@ -15,6 +110,15 @@ void initializeRanks(float *ranks, int N) {
     }
 }
 
+// conv's start vector when it has one, the uniform one otherwise
+void startRanks(float *ranks, int N, Convergence* conv) {
+    if (conv && conv->initial) {
+        if (conv->initial != ranks) memcpy(ranks, conv->initial, N * sizeof(float));
+    } else {
+        initializeRanks(ranks, N);
+    }
+}
+
 void PageRank(Graph *graph, int iterations, float* ranks) {
     int N = graph->numVertices;
     float *newRanks = (float *)malloc(N * sizeof(float));
@@ -60,6 +164,7 @@ void PageRank(Graph *graph, int iterations, float* ranks) {
                 }
             }
             newRanks[i] = D/N +(1-D)*(sumA+sumB);
+            free(out2i);
         }
 
         for (int i = 0; i < N; i++) {
@@ -68,13 +173,15 @@ void PageRank(Graph *graph, int iterations, float* ranks) {
     }
 
     free(newRanks);
+    free(outlinkes);
 }
 
-void GoodPageRank(Graph *graph, int iterations, float* ranks) {
+// conv may be NULL to run a fixed number of iterations
+void GoodPageRankConverge(Graph *graph, int iterations, float* ranks, Convergence* conv) {
 
     int N = graph->numVertices;
     float *newRanks = (float *)malloc(N * sizeof(float));
-    initializeRanks(ranks, N);
+    startRanks(ranks, N, conv);
 
     for (int iter = 0; iter < iterations; iter++) {
 
@@ -97,332 +204,2617 @@ void GoodPageRank(Graph *graph, int iterations, float* ranks) {
             newRanks[i] = D/N +(1-D)*(sumA+sumB);
         }
 
+        double l1 = 0.0, linf = 0.0;
         for (int i = 0; i < N; i++) {
+            double diff = fabs(newRanks[i] - ranks[i]);
+            l1 += diff;
+            if (diff > linf) linf = diff;
             ranks[i] = newRanks[i];
         }
+        if (recordIteration(conv, iter, l1, linf, ranks, N)) break;
     }
 
     free(newRanks);
 }
 
-void help (Graph* graph, float* ranks, float* newRanks, int start, int end, double sumB, int N) {
-    
-    for (int i=start; i < end; i++) {
-        //calculate i rank
-        double sumA = 0.0;
-        node* u = graph->adjacencyListsIn[i];
-        while (u != NULL) {
-            // u->v is the id
-            sumA += ranks[u->v]/graph->adjacencyListsOutLength[u->v];
-            u = u->next;
-        }
-        newRanks[i] = D/N +(1-D)*(sumA+sumB);
-    }
+void GoodPageRank(Graph *graph, int iterations, float* ranks) {
+    GoodPageRankConverge(graph, iterations, ranks, NULL);
 }
 
-typedef struct ThreadData {
-    Graph* graph;
-    float* ranks;
-    float* newRanks;
-    int start;
-    int end;
-    double sumB;
-    int N;
-} ThreadData;
-
-typedef struct Task {
-    ThreadData* data;
-    struct Task* next;
-} Task;
+void GoodPageRankCSRConverge(CSRGraph *csr, int iterations, float* ranks, Convergence* conv) {
 
-typedef struct TaskQueue {
-    Task* front;
-    Task* back;
-    pthread_mutex_t mutex;
-    pthread_cond_t cond;
-} TaskQueue;
+    int N = csr->numVertices;
+    float *newRanks = (float *)malloc(N * sizeof(float));
+    startRanks(ranks, N, conv);
 
-typedef struct ThreadPool {
-    // how many to join
-    int thread_count;
-    int stop;
-    pthread_t* threads;
-    TaskQueue queue;
-    int pending_tasks;
-    pthread_mutex_t lock;
-    pthread_cond_t done;
-} ThreadPool;
+    for (int iter = 0; iter < iterations; iter++) {
 
-void initQueue (TaskQueue* queue) {
-    queue->front = queue->back = NULL;
-    pthread_mutex_init(&queue->mutex, NULL);
-    pthread_cond_init(&queue->cond, NULL);
-}
+        double sumB = 0.0;
+        // calculate the sum of ranks of those without outlinks
+        for (int i=0; i < N; i++) {
+            sumB += (csr->outDegree[i] == 0) ? ranks[i]/N : 0;
+        }
 
-void enqueue (ThreadPool* pool, ThreadData* data) {
-    Task* task = malloc(sizeof(Task));
-    task->data = data;
-    task->next = NULL;
+        for (int i = 0; i < N; i++) {
+            // in-neighbors of i are contiguous, no pointer chasing
+            double sumA = 0.0;
+            for (long k = csr->inOffsets[i]; k < csr->inOffsets[i+1]; k++) {
+                vertex u = csr->inNeighbors[k];
+                sumA += ranks[u]/csr->outDegree[u];
+            }
+            newRanks[i] = D/N +(1-D)*(sumA+sumB);
+        }
 
-    pthread_mutex_lock(&pool->queue.mutex);
-    if (pool->queue.back == NULL) {
-        pool->queue.front = pool->queue.back = task;
-    } else {
-        pool->queue.back->next = task;
-        pool->queue.back = task;
+        double l1 = 0.0, linf = 0.0;
+        for (int i = 0; i < N; i++) {
+            double diff = fabs(newRanks[i] - ranks[i]);
+            l1 += diff;
+            if (diff > linf) linf = diff;
+            ranks[i] = newRanks[i];
+        }
+        if (recordIteration(conv, iter, l1, linf, ranks, N)) break;
     }
-    pthread_mutex_unlock(&pool->queue.mutex);
-
-    pthread_mutex_lock(&pool->queue.mutex);
-    pool->pending_tasks++;
-    pthread_mutex_unlock(&pool->queue.mutex);
 
-    // signal new task
-    pthread_cond_signal(&pool->queue.cond);
+    free(newRanks);
 }
 
-ThreadData* dequeue (ThreadPool* pool) {
-
-    pthread_mutex_lock(&pool->queue.mutex);
-    while (pool->queue.front == NULL && !pool->stop) {
-        // wait for available task
-        pthread_cond_wait(&pool->queue.cond, &pool->queue.mutex);
-    }
+void GoodPageRankCSR(CSRGraph *csr, int iterations, float* ranks) {
+    GoodPageRankCSRConverge(csr, iterations, ranks, NULL);
+}
 
-    if (pool->stop) {
-        // stop here
-        pthread_mutex_unlock(&pool->queue.mutex);
-        return NULL;
+// 1/outDegree, 0 for vertices without outlinks
+float* inverseOutDegrees(int* outLength, int N) {
+    float* inv = (float *)malloc(N * sizeof(float));
+    if (!inv) {
+        printf("Memory allocation failed\n");
+        exit(1);
     }
-
-    Task* task = pool->queue.front;
-    pool->queue.front = pool->queue.front->next;
-    if (pool->queue.front == NULL) {
-        pool->queue.back = NULL;
+    for (int i = 0; i < N; i++) {
+        inv[i] = (outLength[i] == 0) ? 0.0f : 1.0f / outLength[i];
     }
-    pthread_mutex_unlock(&pool->queue.mutex);
-
-    ThreadData* data = task->data;
-    free(task);
-    return data;
+    return inv;
 }
 
+// same as GoodPageRankCSR, but every vertex divides its rank once per
+// iteration and the edge loop is a plain gather and add
+void GoodPageRankContrib(CSRGraph *csr, int iterations, float* ranks, Convergence* conv) {
 
-void* help2 (ThreadData* data) {
+    int N = csr->numVertices;
+    float *newRanks = (float *)malloc(N * sizeof(float));
+    float *contrib = (float *)malloc(N * sizeof(float));
+    float *invOutDeg = inverseOutDegrees(csr->outDegree, N);
+    startRanks(ranks, N, conv);
 
-    for (int i=data->start; i < data->end; i++) {
-        //calculate i rank
-        double sumA = 0.0;
-        node* u = data->graph->adjacencyListsIn[i];
-        while (u != NULL) {
-            // u->v is the id
-            sumA += data->ranks[u->v]/data->graph->adjacencyListsOutLength[u->v];
-            u = u->next;
+    for (int iter = 0; iter < iterations; iter++) {
+
+        double sumB = 0.0;
+        // dangling sum and contributions in one pass
+        for (int i=0; i < N; i++) {
+            sumB += (csr->outDegree[i] == 0) ? ranks[i]/N : 0;
+            contrib[i] = ranks[i] * invOutDeg[i];
         }
-        data->newRanks[i] = D/data->N +(1-D)*(sumA+data->sumB);
-    }
-    return NULL;
-}
 
-void* worker_thread (void* arg) {
-    ThreadPool* pool = (ThreadPool*)arg;
-    while (1) {
-        // sleeps thread until task available
-        ThreadData* data = dequeue(pool);
-        if (data == NULL) {
-            break; // error
+        for (int i = 0; i < N; i++) {
+            double sumA = 0.0;
+            for (long k = csr->inOffsets[i]; k < csr->inOffsets[i+1]; k++) {
+                sumA += contrib[csr->inNeighbors[k]];
+            }
+            newRanks[i] = D/N +(1-D)*(sumA+sumB);
         }
-        help2(data);
 
-        pthread_mutex_lock(&pool->queue.mutex);
-        pool->pending_tasks--;
-        if (pool->pending_tasks == 0) {
-            pthread_cond_signal(&pool->done);
+        double l1 = 0.0, linf = 0.0;
+        for (int i = 0; i < N; i++) {
+            double diff = fabs(newRanks[i] - ranks[i]);
+            l1 += diff;
+            if (diff > linf) linf = diff;
+            ranks[i] = newRanks[i];
         }
-        pthread_mutex_unlock(&pool->queue.mutex);
+        if (recordIteration(conv, iter, l1, linf, ranks, N)) break;
     }
-    return NULL; // error
+
+    free(invOutDeg);
+    free(contrib);
+    free(newRanks);
 }
 
-void initPool(ThreadPool* pool, int thread_count) {
-    pool->thread_count = thread_count;
-    pool->stop = 0;
-    pool->threads = malloc(thread_count * sizeof(pthread_t));
-    if (!pool->threads) {
-        perror("failed to allocate threads");
-        exit(EXIT_FAILURE);
-    }
+// GoodPageRankContrib with the pull kernel of the given SIMD level
+void GoodPageRankSIMD(CSRGraph *csr, int level, int iterations, float* ranks, Convergence* conv) {
 
-    for (int i=0; i < thread_count; i++) {
-        if (pthread_create(&pool->threads[i], NULL, worker_thread, (void*)pool)) {
-            perror("failed to initialize threads");
-            exit(EXIT_FAILURE);
+    int N = csr->numVertices;
+    float *newRanks = (float *)malloc(N * sizeof(float));
+    float *contrib = (float *)malloc(N * sizeof(float));
+    float *invOutDeg = inverseOutDegrees(csr->outDegree, N);
+    PullKernel pull = pullKernel(level);
+    float *out = ranks;
+    startRanks(ranks, N, conv);
+
+    for (int iter = 0; iter < iterations; iter++) {
+
+        double sumB = 0.0;
+        for (int i=0; i < N; i++) {
+            sumB += (csr->outDegree[i] == 0) ? ranks[i]/N : 0;
+            contrib[i] = ranks[i] * invOutDeg[i];
         }
-    }
 
-    initQueue(&pool->queue);
-    pool->pending_tasks = 0;
-    pthread_mutex_init(&pool->lock, NULL);
-    pthread_cond_init(&pool->done, NULL);
-}
+        double l1 = 0.0, linf = 0.0;
+        pull(csr, contrib, ranks, newRanks, 0, N, D/N + (1-D)*sumB, 1-D, &l1, &linf);
 
-void destroyPool(ThreadPool* pool) {
-    // wait for task to end
-    pthread_mutex_lock(&pool->queue.mutex);
-    pool->stop = 1;
-    // wake sleeping threads to stop
-    pthread_cond_broadcast(&pool->queue.cond);
-    pthread_mutex_unlock(&pool->queue.mutex);
+        // pointer swapping instead of assignment
+        float* temp = ranks;
+        ranks = newRanks;
+        newRanks = temp;
 
-    for (int i=0; i < pool->thread_count; i++) {
-        pthread_join(pool->threads[i], NULL);
+        if (recordIteration(conv, iter, l1, linf, ranks, N)) break;
     }
 
-    free(pool->threads);
-    pthread_mutex_destroy(&pool->queue.mutex);
-    pthread_cond_destroy(&pool->queue.cond);
-    pthread_mutex_destroy(&pool->lock);
-    pthread_cond_destroy(&pool->done);
+    if (ranks != out) {
+        memcpy(out, ranks, N * sizeof(float));
+        newRanks = ranks;
+    }
+
+    free(invOutDeg);
+    free(contrib);
+    free(newRanks);
 }
 
-void ParallelPageRank(Graph *graph, int iterations, float* ranks) {
+// GoodPageRankContrib summed tile by tile, each tile gathers from one cached slice of contrib
+void GoodPageRankTiled(TiledGraph *tiled, int iterations, float* ranks, Convergence* conv) {
 
-    int N = graph->numVertices;
-    float *newRanks = (float *)malloc(N * sizeof(float));
+    int N = tiled->numVertices;
+    float *sums = (float *)malloc(N * sizeof(float));
+    float *contrib = (float *)malloc(N * sizeof(float));
+    float *invOutDeg = inverseOutDegrees(tiled->outDegree, N);
+    startRanks(ranks, N, conv);
 
-    // calc ceil
-    int task_count = (N+BLOCK_SIZE-1) / BLOCK_SIZE;
-    int step = N / task_count;
-    int mod = N % task_count;
-    int sub = N - mod;
+    for (int iter = 0; iter < iterations; iter++) {
 
-    ThreadPool* pool = (ThreadPool*) malloc (sizeof(ThreadPool));
-    if (!pool) {
-        perror("failed to allocate threadpool");
-        exit(EXIT_FAILURE);
-    }
-    initPool(pool, T);
-    ThreadData** data = malloc(task_count * sizeof(ThreadData*));
-    for (int i=0; i < task_count; i++) {
-        data[i] = (ThreadData*) malloc(sizeof(ThreadData));
+        double sumB = 0.0;
+        for (int i=0; i < N; i++) {
+            sumB += (tiled->outDegree[i] == 0) ? ranks[i]/N : 0;
+            contrib[i] = ranks[i] * invOutDeg[i];
+        }
+
+        // destinations ascend inside a tile, so sums is streamed once per tile
+        memset(sums, 0, N * sizeof(float));
+        for (int t = 0; t < tiled->numTiles; t++) {
+            for (long e = tiled->tileOffsets[t]; e < tiled->tileOffsets[t+1]; e++) {
+                sums[tiled->dst[e]] += contrib[tiled->src[e]];
+            }
+        }
+
+        double l1 = 0.0, linf = 0.0;
+        for (int i = 0; i < N; i++) {
+            float rank = D/N +(1-D)*(sums[i]+sumB);
+            double diff = fabs(rank - ranks[i]);
+            l1 += diff;
+            if (diff > linf) linf = diff;
+            ranks[i] = rank;
+        }
+        if (recordIteration(conv, iter, l1, linf, ranks, N)) break;
     }
 
-    initializeRanks(ranks, N);
+    free(invOutDeg);
+    free(contrib);
+    free(sums);
+}
+
+// propagation blocking: sources push their contrib into bins by destination
+// range, then every bin is added into a cached slice of sums and finished
+void GoodPageRankBinned(BinnedGraph *binned, int iterations, float* ranks, Convergence* conv) {
+
+    int N = binned->numVertices;
+    int width = 1 << binned->bits;
+    float *sums = (float *)malloc(width * sizeof(float));
+    float *contrib = (float *)malloc(N * sizeof(float));
+    float *binValue = (float *)malloc((binned->numEdges + 1) * sizeof(float));
+    long *cursor = (long *)malloc(binned->numBins * sizeof(long));
+    float *invOutDeg = inverseOutDegrees(binned->outDegree, N);
+    startRanks(ranks, N, conv);
 
     for (int iter = 0; iter < iterations; iter++) {
 
         double sumB = 0.0;
-       
-        // calculate the sum of ranks of those without outlinks
         for (int i=0; i < N; i++) {
-            sumB += (graph->adjacencyListsOutLength[i] == 0) ? ranks[i] : 0;
+            sumB += (binned->outDegree[i] == 0) ? ranks[i]/N : 0;
+            contrib[i] = ranks[i] * invOutDeg[i];
         }
-        sumB /= N;
 
-        int start = 0, end = 0;
-        for (int i=0; i < task_count; i++) {
-            end += ((i==task_count-1 && mod != 0) ? mod : step);
-
-            data[i]->graph=graph; data[i]->ranks=ranks; data[i]->newRanks=newRanks; data[i]->sumB=sumB; data[i]->N=N;
-            data[i]->start = start; data[i]->end = end;
-            enqueue(pool, data[i]);
+        // the writes go to numBins sequential streams, not to random destinations
+        memcpy(cursor, binned->binOffsets, binned->numBins * sizeof(long));
+        for (int u = 0; u < N; u++) {
+            float c = contrib[u];
+            for (long k = binned->outOffsets[u]; k < binned->outOffsets[u+1]; k++) {
+                binValue[cursor[binned->outNeighbors[k] >> binned->bits]++] = c;
+            }
+        }
 
-            start = end;
+        double l1 = 0.0, linf = 0.0;
+        for (int b = 0; b < binned->numBins; b++) {
+            int first = b * width;
+            int last = (first + width < N) ? first + width : N;
+            memset(sums, 0, (last - first) * sizeof(float));
+            for (long e = binned->binOffsets[b]; e < binned->binOffsets[b+1]; e++) {
+                sums[binned->binDst[e] - first] += binValue[e];
+            }
+            for (int i = first; i < last; i++) {
+                float rank = D/N +(1-D)*(sums[i - first]+sumB);
+                double diff = fabs(rank - ranks[i]);
+                l1 += diff;
+                if (diff > linf) linf = diff;
+                ranks[i] = rank;
+            }
         }
+        if (recordIteration(conv, iter, l1, linf, ranks, N)) break;
+    }
 
-        pthread_mutex_lock(&pool->lock);
-        while (pool->queue.front != NULL) {
-            // waits until pool->done signal, releases lock to later reacquire
-            pthread_cond_wait(&pool->done, &pool->lock);
-        };
-        pthread_mutex_unlock(&pool->lock);
+    free(invOutDeg);
+    free(cursor);
+    free(binValue);
+    free(contrib);
+    free(sums);
+}
 
-        // pointer swapping instead of assignment
-        float* temp = ranks;
-        ranks = newRanks; 
-        newRanks = temp;
+// GoodPageRankContrib updated in place: every vertex already reads the new
+// ranks of the vertices before it in the sweep, so it takes fewer sweeps.
+// In place the ranks drift off a sum of 1, and D/N + (1-D)*sumB would keep
+// that error around for many sweeps. Teleport plus dangling mass is the
+// same at a sum of 1 as (1 - (1-D)*linked)/N, linked being the mass of the
+// vertices with outlinks, and that form hands any missing mass back.
+void GaussSeidelPageRank(CSRGraph *csr, int iterations, float* ranks, Convergence* conv) {
+
+    int N = csr->numVertices;
+    float *contrib = (float *)malloc(N * sizeof(float));
+    float *invOutDeg = inverseOutDegrees(csr->outDegree, N);
+    startRanks(ranks, N, conv);
+
+    double linked = 0.0;
+    for (int i=0; i < N; i++) {
+        linked += (csr->outDegree[i] != 0) ? ranks[i] : 0;
+        contrib[i] = ranks[i] * invOutDeg[i];
     }
 
-    destroyPool(pool);
-    free(pool);
-    for (int i=0; i < task_count; i++) free(data[i]);
-    free(data);
-    free(newRanks);
+    for (int iter = 0; iter < iterations; iter++) {
+        double l1 = 0.0, linf = 0.0;
+        for (int i = 0; i < N; i++) {
+            double sumA = 0.0;
+            for (long k = csr->inOffsets[i]; k < csr->inOffsets[i+1]; k++) {
+                sumA += contrib[csr->inNeighbors[k]];
+            }
+            float rank = (1-D)*sumA + (1 - (1-D)*linked)/N;
+            double diff = fabs(rank - ranks[i]);
+            l1 += diff;
+            if (diff > linf) linf = diff;
+            if (csr->outDegree[i] != 0) linked += rank - ranks[i];
+            ranks[i] = rank;
+            contrib[i] = rank * invOutDeg[i];
+        }
+        if (recordIteration(conv, iter, l1, linf, ranks, N)) break;
+    }
+
+    free(invOutDeg);
+    free(contrib);
 }
 
-void generateRandomGraph(Graph* graph, int N, int M) {
-    srand(time(NULL));
-    for(int i = 0; i < M; i++) {
-        int src = rand() % N;
-        int dest = rand() % N;
-        if(src != dest) { // Avoid self-loops
-            addEdge(graph, src, dest);
+// what a thread of AsyncPageRank publishes after each of its sweeps
+typedef struct __attribute__((aligned(64))) AsyncThread {
+    struct AsyncRun* run;
+    int id;
+    int start;
+    int end;
+    _Atomic double linked; // rank mass of the vertices with outlinks in [start, end)
+    _Atomic double l1;     // residual of the last sweep
+    _Atomic double linf;
+    atomic_int sweeps;
+} AsyncThread;
+
+typedef struct AsyncRun {
+    CSRGraph* csr;
+    float* ranks;           // each thread only touches its own range
+    _Atomic float* contrib; // read by all, written by the owner of the vertex
+    float* invOutDeg;
+    AsyncThread* threads;
+    int threadCount;
+    int iterations;
+    atomic_int stop;
+} AsyncRun;
+
+// one in-place sweep of the thread's range, then its results are published
+static void asyncSweep(AsyncThread* self) {
+    AsyncRun* run = self->run;
+    CSRGraph* csr = run->csr;
+    int N = csr->numVertices;
+    // the other ranges as of their last sweep, ours as of the last vertex
+    double own = atomic_load_explicit(&self->linked, memory_order_relaxed);
+    double others = 0.0;
+    for (int t = 0; t < run->threadCount; t++) {
+        if (t != self->id) others += atomic_load_explicit(&run->threads[t].linked, memory_order_relaxed);
+    }
+
+    // locals, the atomics would otherwise make the compiler reload them for every edge
+    float* ranks = run->ranks;
+    _Atomic float* contrib = run->contrib;
+    const float* invOutDeg = run->invOutDeg;
+    const long* inOffsets = csr->inOffsets;
+    const vertex* inNeighbors = csr->inNeighbors;
+    const int* outDegree = csr->outDegree;
+    double l1 = 0.0, linf = 0.0;
+    for (int i = self->start; i < self->end; i++) {
+        double sumA = 0.0;
+        for (long k = inOffsets[i]; k < inOffsets[i+1]; k++) {
+            sumA += atomic_load_explicit(&contrib[inNeighbors[k]], memory_order_relaxed);
         }
+        float rank = (1-D)*sumA + (1 - (1-D)*(own+others))/N;
+        double diff = fabs(rank - ranks[i]);
+        l1 += diff;
+        if (diff > linf) linf = diff;
+        if (outDegree[i] != 0) own += rank - ranks[i];
+        ranks[i] = rank;
+        atomic_store_explicit(&contrib[i], rank * invOutDeg[i], memory_order_relaxed);
     }
+
+    atomic_store_explicit(&self->linked, own, memory_order_relaxed);
+    atomic_store_explicit(&self->l1, l1, memory_order_relaxed);
+    atomic_store_explicit(&self->linf, linf, memory_order_relaxed);
+    atomic_fetch_add_explicit(&self->sweeps, 1, memory_order_relaxed);
 }
 
-int main(void) {
-    int N = 1000; // number of nodes
-    int iterations = 100; // number of iterations
+static int slowestSweeps(AsyncRun* run) {
+    int slowest = run->iterations;
+    for (int t = 0; t < run->threadCount; t++) {
+        int s = atomic_load_explicit(&run->threads[t].sweeps, memory_order_relaxed);
+        if (s < slowest) slowest = s;
+    }
+    return slowest;
+}
 
-    // Initialize the graph
-    Graph *graph = createGraph(N);
-    generateRandomGraph(graph, N, 10000);
-    
-    // Calculate PageRank
-    float *ranks = (float *)malloc(N * sizeof(float));
-    double start, end, total=0;
+void* asyncSweeps(void* arg) {
+    AsyncThread* self = (AsyncThread*)arg;
+    AsyncRun* run = self->run;
+    for (int sweep = 0; sweep < run->iterations; sweep++) {
+        // not a barrier, the slowest thread never waits
+        while (sweep - slowestSweeps(run) >= ASYNC_LEAD) {
+            if (atomic_load_explicit(&run->stop, memory_order_relaxed)) return NULL;
+            sched_yield();
+        }
+        if (atomic_load_explicit(&run->stop, memory_order_relaxed)) break;
+        asyncSweep(self);
+    }
+    return NULL;
+}
 
-    start = (double)clock() / CLOCKS_PER_SEC;
-    PageRank(graph, iterations, ranks);
-    end   = (double)clock() / CLOCKS_PER_SEC;
-    total += (end-start);
-    
-    // Print the ranks
-    // for (int i = 0; i < N; i++) {
-    //     printf("Serial - Rank of node %d: %f\n", i, ranks[i]);
-    // }
-    printf("time to calc: %lf\n", total);
-
-    total = 0;
-    start = (double)clock() / CLOCKS_PER_SEC;
-    GoodPageRank(graph, iterations, ranks);
-    end   = (double)clock() / CLOCKS_PER_SEC;
-    total += (end-start);
-
-    // Print the ranks
-    // for (int i = 0; i < N; i++) {
-    //     printf("Good - Rank of node %d: %f\n", i, ranks[i]);
-    // }
-    printf("time to calc: %lf\n", total);
-    
+/*
+ * Gauss-Seidel on threadCount threads without a barrier between sweeps.
+ * Each thread owns a range of about the same in-edges and sweeps it in
+ * place as often as it can, reading whatever contrib the other threads
+ * last stored. The loads and stores are relaxed atomics: a stale value
+ * only delays convergence, it can't be torn. A thread only waits once it is
+ * ASYNC_LEAD sweeps ahead of the slowest, or with more threads than cores
+ * one could run all its sweeps against inputs that never move. The dangling
+ * mass is taken as in GaussSeidelPageRank, from the linked mass each thread
+ * last published. The calling thread sweeps range 0 and
+ * records iteration k in conv once every thread has finished k+1 sweeps,
+ * with the residuals each last published. It starts from conv's start
+ * vector, but writes no checkpoints, the ranks are never still mid-run.
+ */
+void AsyncPageRank(CSRGraph *csr, int iterations, float* ranks, Convergence* conv) {
 
-    total = 0;
-    start = (double)clock() / CLOCKS_PER_SEC;
-    ParallelPageRank(graph, iterations, ranks);
-    end   = (double)clock() / CLOCKS_PER_SEC;
-    total += (end-start);
+    int N = csr->numVertices;
+    int threads = threadCount < N ? threadCount : (N > 0 ? N : 1);
+    AsyncRun run;
+    run.csr = csr;
+    run.ranks = ranks;
+    run.contrib = (_Atomic float *)malloc(N * sizeof(_Atomic float));
+    run.invOutDeg = inverseOutDegrees(csr->outDegree, N);
+    run.threads = (AsyncThread *)aligned_alloc(64, threads * sizeof(AsyncThread));
+    run.threadCount = threads;
+    run.iterations = iterations;
+    atomic_init(&run.stop, 0);
+    int* bounds = (int *)malloc((threads + 1) * sizeof(int));
+    pthread_t* tids = (pthread_t *)malloc(threads * sizeof(pthread_t));
+    if (!run.contrib || !run.threads || !bounds || !tids) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    partitionByInEdges(NULL, csr, threads, bounds);
 
-    // Print the ranks
-    // for (int i = 0; i < N; i++) {
-    //     printf("Parallel - Rank of node %d: %f\n", i, ranks[i]);
-    // }
-    printf("time to calc: %lf\n", total);
+    startRanks(ranks, N, conv);
+    for (int i = 0; i < N; i++) atomic_init(&run.contrib[i], ranks[i] * run.invOutDeg[i]);
+    for (int t = 0; t < threads; t++) {
+        AsyncThread* a = &run.threads[t];
+        a->run = &run;
+        a->id = t;
+        a->start = bounds[t];
+        a->end = bounds[t+1];
+        double linked = 0.0;
+        for (int i = a->start; i < a->end; i++) linked += (csr->outDegree[i] != 0) ? ranks[i] : 0;
+        atomic_init(&a->linked, linked);
+        atomic_init(&a->l1, 0.0);
+        atomic_init(&a->linf, 0.0);
+        atomic_init(&a->sweeps, 0);
+    }
 
-    // Free allocated memory
-    for (int i = 0; i < N; i++) {
-        node *adjList = graph->adjacencyListsOut[i];
-        while (adjList != NULL) {
-            node *temp = adjList;
-            adjList = adjList->next;
-            free(temp);
+    for (int t = 1; t < threads; t++) {
+        if (pthread_create(&tids[t], NULL, asyncSweeps, &run.threads[t])) {
+            perror("failed to create thread");
+            exit(EXIT_FAILURE);
         }
     }
-    
 
+    // sweeps while it has some left and isn't too far ahead, otherwise only watches
+    int recorded = 0, mine = 0;
+    while (recorded < iterations) {
+        if (mine < iterations && mine - recorded < ASYNC_LEAD) {
+            asyncSweep(&run.threads[0]);
+            mine++;
+        } else {
+            sched_yield();
+        }
+        int done = slowestSweeps(&run);
+        if (done == recorded) continue;
+
+        double l1 = 0.0, linf = 0.0;
+        for (int t = 0; t < threads; t++) {
+            l1 += atomic_load_explicit(&run.threads[t].l1, memory_order_relaxed);
+            double m = atomic_load_explicit(&run.threads[t].linf, memory_order_relaxed);
+            if (m > linf) linf = m;
+        }
+
+        // iterations every thread passed at once share the residuals seen now
+        int converged = 0;
+        while (recorded < done) converged = recordResidual(conv, recorded++, l1, linf);
+        if (converged) {
+            atomic_store_explicit(&run.stop, 1, memory_order_relaxed);
+            break;
+        }
+    }
+    for (int t = 1; t < threads; t++) pthread_join(tids[t], NULL);
+
+    free(tids);
+    free(bounds);
+    free(run.threads);
+    free(run.invOutDeg);
+    free(run.contrib);
+}
+
+// partials of one DeltaPageRank task, reduced by the main thread
+typedef struct __attribute__((aligned(64))) DeltaTask {
+    double l1;       // residual pushed
+    double linf;
+    double dangling; // the part of it pushed by vertices without outlinks
+    long edges;      // edges processed
+    int count;       // vertices a dense round put in the next frontier
+    long outEdges;   // and their out-edges
+} DeltaTask;
+
+typedef struct DeltaRun {
+    CSRGraph* csr;
+    _Atomic float* residual; // change not applied yet, added to with CAS by any thread
+    double* settled;         // ranks with every applied change
+    float* share;            // dense rounds, what each active vertex gives an out-neighbor, else 0
+    float* invOutDeg;
+    float epsilon;           // vertices with residual epsilon times their rank either way are active
+    float* limit;            // epsilon times v's rank as of the last dense round
+    float threshold;         // epsilon times the average rank, for the pending share
+    double uniform;          // residual every vertex gets in this dense round
+    Frontier* current;
+    Frontier* next;
+    int* bounds;             // dense rounds, vertex ranges by in-edges
+    DeltaTask* tasks;
+} DeltaRun;
+
+static inline float addResidual(_Atomic float* residual, vertex v, float w) {
+    float old = atomic_load_explicit(&residual[v], memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&residual[v], &old, old + w, memory_order_relaxed,
+                                                  memory_order_relaxed)) {}
+    return old + w;
+}
+
+// lists a batch of newly active vertices in the next frontier with one fetch_add
+static void flushActive(Frontier* next, int* batch, int count) {
+    int at = atomic_fetch_add_explicit(&next->count, count, memory_order_relaxed);
+    memcpy(next->ids + at, batch, count * sizeof(int));
+}
+
+// sparse round: each active vertex of chunk t applies its residual and pushes it on
+void deltaPush(void* ctx, int t) {
+    DeltaRun* run = (DeltaRun*)ctx;
+    DeltaTask* task = &run->tasks[t];
+    CSRGraph* csr = run->csr;
+    int count = atomic_load_explicit(&run->current->count, memory_order_relaxed);
+    int first = t * DELTA_CHUNK;
+    int last = (first + DELTA_CHUNK < count) ? first + DELTA_CHUNK : count;
+    int batch[DELTA_BATCH];
+    int batched = 0;
+    double l1 = 0.0, linf = 0.0, dangling = 0.0;
+    long edges = 0, outEdges = 0;
+
+    for (int j = first; j < last; j++) {
+        vertex u = run->current->ids[j];
+        float r = atomic_exchange_explicit(&run->residual[u], 0.0f, memory_order_relaxed);
+        run->settled[u] += r;
+        l1 += fabs(r);
+        if (fabs(r) > linf) linf = fabs(r);
+        if (csr->outDegree[u] == 0) {
+            dangling += r;
+            continue;
+        }
+        float w = (1-D) * r * run->invOutDeg[u];
+        edges += csr->outDegree[u];
+        for (long k = csr->outOffsets[u]; k < csr->outOffsets[u+1]; k++) {
+            vertex v = csr->outNeighbors[k];
+            if (fabsf(addResidual(run->residual, v, w)) < run->limit[v] || !markVertex(run->next, v)) continue;
+            batch[batched++] = v;
+            outEdges += csr->outDegree[v];
+            if (batched == DELTA_BATCH) {
+                flushActive(run->next, batch, batched);
+                batched = 0;
+            }
+        }
+    }
+    if (batched) flushActive(run->next, batch, batched);
+    task->l1 = l1;
+    task->linf = linf;
+    task->dangling = dangling;
+    task->edges = edges;
+    task->outEdges = outEdges;
+}
+
+// dense round, first half: the active vertices of range t apply their residual
+void deltaGather(void* ctx, int t) {
+    DeltaRun* run = (DeltaRun*)ctx;
+    DeltaTask* task = &run->tasks[t];
+    double l1 = 0.0, linf = 0.0, dangling = 0.0;
+    for (int u = run->bounds[t]; u < run->bounds[t+1]; u++) {
+        if (!inFrontier(run->current, u)) {
+            run->share[u] = 0.0f;
+            continue;
+        }
+        float r = atomic_load_explicit(&run->residual[u], memory_order_relaxed);
+        atomic_store_explicit(&run->residual[u], 0.0f, memory_order_relaxed);
+        run->settled[u] += r;
+        l1 += fabs(r);
+        if (fabs(r) > linf) linf = fabs(r);
+        if (run->csr->outDegree[u] == 0) dangling += r;
+        run->share[u] = (1-D) * r * run->invOutDeg[u];
+    }
+    task->l1 = l1;
+    task->linf = linf;
+    task->dangling = dangling;
+}
+
+// dense round, second half: range t pulls the shares, no atomics as it owns its residuals
+void deltaPull(void* ctx, int t) {
+    DeltaRun* run = (DeltaRun*)ctx;
+    DeltaTask* task = &run->tasks[t];
+    CSRGraph* csr = run->csr;
+    int count = 0;
+    long outEdges = 0;
+    for (int v = run->bounds[t]; v < run->bounds[t+1]; v++) {
+        double sum = run->uniform;
+        for (long k = csr->inOffsets[v]; k < csr->inOffsets[v+1]; k++) {
+            sum += run->share[csr->inNeighbors[k]];
+        }
+        float r = atomic_load_explicit(&run->residual[v], memory_order_relaxed) + (float)sum;
+        atomic_store_explicit(&run->residual[v], r, memory_order_relaxed);
+        // sparse rounds only read limit, so it's refreshed here where range t owns v
+        run->limit[v] = run->epsilon * run->settled[v];
+        if (fabsf(r) >= run->limit[v] && markVertex(run->next, v)) {
+            count++;
+            outEdges += csr->outDegree[v];
+        }
+    }
+    task->edges = csr->inOffsets[run->bounds[t+1]] - csr->inOffsets[run->bounds[t]];
+    task->count = count;
+    task->outEdges = outEdges;
+}
+
+// reduces a round's tasks into the next frontier and makes it the current one
+static void finishDeltaRound(DeltaRun* run, int tasks, int dense, double* l1, double* linf, double* dangling,
+                             long* edges) {
+    long outEdges = 0;
+    int active = 0;
+    *l1 = *linf = *dangling = 0.0;
+    for (int t = 0; t < tasks; t++) {
+        *l1 += run->tasks[t].l1;
+        if (run->tasks[t].linf > *linf) *linf = run->tasks[t].linf;
+        *dangling += run->tasks[t].dangling;
+        *edges += run->tasks[t].edges;
+        outEdges += run->tasks[t].outEdges;
+        active += run->tasks[t].count;
+    }
+    // a dense round only set bits, a sparse one listed the vertices as it went
+    if (dense) {
+        run->next->dense = 1;
+        atomic_store_explicit(&run->next->count, active, memory_order_relaxed);
+    }
+    run->next->edges = outEdges;
+
+    Frontier* done = run->current;
+    run->current = run->next;
+    run->next = done;
+    clearFrontier(run->next);
+
+    // the representation the next round is cheapest with, ids are only rebuilt going sparse
+    int count = atomic_load_explicit(&run->current->count, memory_order_relaxed);
+    if (count + run->current->edges > run->csr->numEdges / DELTA_DENSE) run->current->dense = 1;
+    else if (run->current->dense) frontierToSparse(run->current);
+}
+
+/*
+ * Push based PageRank that only works on vertices whose rank still moves.
+ * It starts from the uniform ranks, or conv's start vector, with the change
+ * the first iteration would make as every vertex's residual. An active
+ * vertex applies its residual to its rank and pushes (1-D) of it along its
+ * out-edges, and a vertex is active while its residual is at least
+ * tolerance times its rank either way. The changes left then add up to less
+ * than the tolerance, as in the pull engines, and also leave no vertex off
+ * by more than that fraction of its rank. The run stops when the frontier
+ * empties, not on the L1 pushed per round: after a warm start on a slightly
+ * changed graph that is below the tolerance from the first round while the
+ * ranks near the change are still off by far more. The residuals sum to 0
+ * and shrink as fast as the changes of the power iteration, where a push
+ * from zero ranks would only lose 1-D per round. Changes reaching a
+ * dangling vertex go to all N: a dense round hands them out in the same
+ * round, a sparse one keeps them as a pending share each, which forces a
+ * dense round once it reaches the threshold.
+ *
+ * A round pushes from the frontier in chunks of DELTA_CHUNK with CAS adds
+ * while it is small. Once its vertices and out-edges pass numEdges /
+ * DELTA_DENSE the round pulls instead, over all in-edges against the
+ * bitmap, without atomics. conv gets the residual pushed per round,
+ * tolerance from conv, TOLERANCE without it. Returns the edges processed.
+ */
+long DeltaPageRank(CSRGraph *csr, int iterations, float* ranks, Convergence* conv) {
+
+    int N = csr->numVertices;
+    double tolerance = (conv && conv->tolerance > 0) ? conv->tolerance : TOLERANCE;
+    int denseTasks = (N+BLOCK_SIZE-1) / BLOCK_SIZE;
+    int sparseTasks = (N+DELTA_CHUNK-1) / DELTA_CHUNK;
+    int maxTasks = denseTasks > sparseTasks ? denseTasks : sparseTasks;
+
+    DeltaRun run;
+    run.csr = csr;
+    run.residual = (_Atomic float *)malloc(N * sizeof(_Atomic float));
+    run.settled = (double *)malloc(N * sizeof(double));
+    run.share = (float *)malloc(N * sizeof(float));
+    run.invOutDeg = inverseOutDegrees(csr->outDegree, N);
+    run.epsilon = tolerance;
+    run.limit = (float *)malloc(N * sizeof(float));
+    run.threshold = tolerance / N;
+    run.current = createFrontier(N);
+    run.next = createFrontier(N);
+    run.bounds = (int *)malloc((denseTasks + 1) * sizeof(int));
+    run.tasks = (DeltaTask *)aligned_alloc(64, (maxTasks > 0 ? maxTasks : 1) * sizeof(DeltaTask));
+    if (!run.residual || !run.settled || !run.share || !run.limit || !run.bounds || !run.tasks) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    partitionByInEdges(NULL, csr, denseTasks, run.bounds);
+    StealPool* pool = createStealPool(threadCount, maxTasks);
+
+    // the first iteration's change as one dense pull: minus the start ranks plus what they bring
+    const float* start = conv ? conv->initial : NULL;
+    double danglingMass = 0.0;
+    for (int i = 0; i < N; i++) {
+        double rank = start ? start[i] : 1.0 / N;
+        run.settled[i] = rank;
+        atomic_init(&run.residual[i], (float)-rank);
+        run.share[i] = (1-D) * run.invOutDeg[i] * rank;
+        if (csr->outDegree[i] == 0) danglingMass += rank;
+    }
+    run.uniform = D/N + (1-D) * danglingMass / N;
+    memset(run.tasks, 0, denseTasks * sizeof(DeltaTask));
+    runTasks(pool, denseTasks, deltaPull, &run);
+    double l1, linf, dangling, pending = 0.0;
+    long edges = 0;
+    finishDeltaRound(&run, denseTasks, 1, &l1, &linf, &dangling, &edges);
+
+    for (int round = 0; round < iterations; round++) {
+        int count = atomic_load_explicit(&run.current->count, memory_order_relaxed);
+        int fold = fabs(pending) >= run.threshold;
+        if (count == 0 && !fold) break;
+        // the pending share reaches every vertex, only a dense round visits them all
+        if (fold) run.current->dense = 1;
+
+        int dense = run.current->dense;
+        int tasks = dense ? denseTasks : (count+DELTA_CHUNK-1) / DELTA_CHUNK;
+        memset(run.tasks, 0, tasks * sizeof(DeltaTask));
+        if (dense) {
+            runTasks(pool, tasks, deltaGather, &run);
+            // what the dangling vertices just gave goes out in this round, as in the pull engines
+            for (int t = 0; t < tasks; t++) pending += (1-D) * run.tasks[t].dangling / N;
+            run.uniform = pending;
+            pending = 0.0;
+            runTasks(pool, tasks, deltaPull, &run);
+        } else {
+            runTasks(pool, tasks, deltaPush, &run);
+        }
+        finishDeltaRound(&run, tasks, dense, &l1, &linf, &dangling, &edges);
+        if (!dense) pending += (1-D) * dangling / N;
+
+        // the emptied frontier ends the run, conv only keeps the history
+        recordResidual(conv, round, l1, linf);
+    }
+
+    // what is left is below the limits, it's added in as it stands
+    for (int i = 0; i < N; i++) {
+        ranks[i] = (float)(run.settled[i] + atomic_load_explicit(&run.residual[i], memory_order_relaxed) + pending);
+    }
+
+    destroyStealPool(pool);
+    freeFrontier(run.current);
+    freeFrontier(run.next);
+    free(run.tasks);
+    free(run.bounds);
+    free(run.invOutDeg);
+    free(run.limit);
+    free(run.share);
+    free(run.settled);
+    free(run.residual);
+    return edges;
+}
+
+/*
+ * Personalized PageRank for K queries in one run. Query q teleports to its
+ * seeds, seeds[seedOffsets[q]] .. seeds[seedOffsets[q+1] - 1], instead of
+ * to all N, and its dangling mass goes back to them too, so every query's
+ * ranks sum to 1 as in the global engines. ranks holds N*K floats with the
+ * K ranks of a vertex side by side, so the batch kernel walks each in-list
+ * once for the whole batch and adds the K contributions of a neighbor as
+ * whole vectors. conv gets the largest L1 change of the batch.
+ */
+void PersonalizedPageRank(CSRGraph *csr, int level, int K, const int* seedOffsets, const int* seeds,
+                          int iterations, float* ranks, Convergence* conv) {
+
+    int N = csr->numVertices;
+    long NK = (long)N * K;
+    float *newRanks = (float *)malloc(NK * sizeof(float));
+    float *contrib = (float *)malloc(NK * sizeof(float));
+    double *dangling = (double *)malloc(K * sizeof(double));
+    double *l1 = (double *)malloc(K * sizeof(double));
+    if (!newRanks || !contrib || !dangling || !l1) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    float *invOutDeg = inverseOutDegrees(csr->outDegree, N);
+    BatchKernel pull = batchKernel(level);
+    float *out = ranks;
+
+    // every query starts on its seeds
+    memset(ranks, 0, NK * sizeof(float));
+    for (int q = 0; q < K; q++) {
+        int count = seedOffsets[q+1] - seedOffsets[q];
+        for (int s = seedOffsets[q]; s < seedOffsets[q+1]; s++) ranks[(long)seeds[s] * K + q] += 1.0f / count;
+    }
+
+    for (int iter = 0; iter < iterations; iter++) {
+
+        for (int q = 0; q < K; q++) dangling[q] = 0.0;
+        for (int i = 0; i < N; i++) {
+            const float *row = ranks + (long)i * K;
+            float *next = contrib + (long)i * K;
+            if (csr->outDegree[i] == 0) {
+                for (int q = 0; q < K; q++) dangling[q] += row[q];
+            }
+            for (int q = 0; q < K; q++) next[q] = row[q] * invOutDeg[i];
+        }
+
+        pull(csr, contrib, newRanks, K, 0, N, 1-D);
+
+        // the teleport and the dangling mass, back to the seeds
+        for (int q = 0; q < K; q++) {
+            int count = seedOffsets[q+1] - seedOffsets[q];
+            float share = (float)((D + (1-D) * dangling[q]) / count);
+            for (int s = seedOffsets[q]; s < seedOffsets[q+1]; s++) newRanks[(long)seeds[s] * K + q] += share;
+        }
+
+        double maxL1 = 0.0, linf = 0.0;
+        for (int q = 0; q < K; q++) l1[q] = 0.0;
+        for (int i = 0; i < N; i++) {
+            const float *row = ranks + (long)i * K;
+            const float *next = newRanks + (long)i * K;
+            for (int q = 0; q < K; q++) {
+                double diff = fabs(next[q] - row[q]);
+                l1[q] += diff;
+                if (diff > linf) linf = diff;
+            }
+        }
+        for (int q = 0; q < K; q++) if (l1[q] > maxL1) maxL1 = l1[q];
+
+        // pointer swapping instead of assignment
+        float* temp = ranks;
+        ranks = newRanks;
+        newRanks = temp;
+
+        if (recordResidual(conv, iter, maxL1, linf)) break;
+    }
+
+    if (ranks != out) {
+        memcpy(out, ranks, NK * sizeof(float));
+        newRanks = ranks;
+    }
+
+    free(invOutDeg);
+    free(l1);
+    free(dangling);
+    free(contrib);
+    free(newRanks);
+}
+
+// one change of a batch for updateDynamicRanks
+typedef struct EdgeUpdate {
+    vertex source;
+    vertex destination;
+    int insert; // 0 removes the edge
+} EdgeUpdate;
+
+/*
+ * PageRank kept up to date while edges come and go, on the lists of a
+ * Graph that the updates change in place. The ranks are settled + residual
+ * + common: residual[v] is what one more pull would change v by, common is
+ * the part of it all N share, from the dangling vertices, as the pending
+ * share of DeltaPageRank. A vertex whose residual reaches tolerance/N is
+ * queued and pushed, where DeltaPageRank scales that limit with the rank,
+ * one vertex at a time from a FIFO, since a batch of updates only wakes a
+ * few of them. Pushing common out to all N would wake every vertex, it's
+ * folded in by scaling instead.
+ */
+typedef struct DynamicRanks {
+    Graph* graph;
+    double* settled;
+    double* residual;
+    double common;
+    double threshold;
+    int* queue;     // ring of numVertices entries, each vertex in it at most once
+    char* queued;
+    char* touched;  // sources of the batch being applied
+    int head;
+    int count;
+    long edges;     // out-edges pushed along so far
+} DynamicRanks;
+
+static inline void queueVertex(DynamicRanks* dyn, vertex v) {
+    if (dyn->queued[v] || fabs(dyn->residual[v]) < dyn->threshold) return;
+    int N = dyn->graph->numVertices;
+    dyn->queue[(dyn->head + dyn->count) % N] = v;
+    dyn->count++;
+    dyn->queued[v] = 1;
+}
+
+// pushes until no residual reaches the threshold, common included
+static void settleDynamicRanks(DynamicRanks* dyn) {
+    Graph* graph = dyn->graph;
+    int N = graph->numVertices;
+    for (;;) {
+        while (dyn->count > 0) {
+            vertex v = dyn->queue[dyn->head];
+            dyn->head = (dyn->head + 1) % N;
+            dyn->count--;
+            dyn->queued[v] = 0;
+
+            double r = dyn->residual[v];
+            dyn->settled[v] += r;
+            dyn->residual[v] = 0.0;
+            int degree = graph->adjacencyListsOutLength[v];
+            if (degree == 0) {
+                dyn->common += (1-D) * r / N;
+                continue;
+            }
+            double share = (1-D) * r / degree;
+            for (node* w = graph->adjacencyListsOut[v]; w != NULL; w = w->next) {
+                dyn->residual[w->v] += share;
+                queueVertex(dyn, w->v);
+            }
+            dyn->edges += degree;
+        }
+        if (fabs(dyn->common) < dyn->threshold) break;
+        // a residual of c at every vertex settles into (cN/D) times the ranks, which the settled
+        // ones stand in for: scaling settled and residual by 1 + cN/D leaves a common of c^2 N/D
+        double alpha = dyn->common * N / D;
+        for (int i = 0; i < N; i++) {
+            dyn->settled[i] *= 1 + alpha;
+            dyn->residual[i] *= 1 + alpha;
+            queueVertex(dyn, i);
+        }
+        dyn->common *= alpha;
+    }
+}
+
+/*
+ * Starts from ranks, the vector of an earlier run, or from the uniform one
+ * when NULL. One pull over the in-lists gives the residuals, which are then
+ * pushed down to tolerance (TOLERANCE when <= 0) in L1.
+ */
+void initDynamicRanks(DynamicRanks* dyn, Graph* graph, const float* ranks, double tolerance) {
+    int N = graph->numVertices;
+    dyn->graph = graph;
+    dyn->settled = (double*)malloc(N * sizeof(double));
+    dyn->residual = (double*)malloc(N * sizeof(double));
+    dyn->queue = (int*)malloc(N * sizeof(int));
+    dyn->queued = (char*)calloc(N, sizeof(char));
+    dyn->touched = (char*)calloc(N, sizeof(char));
+    if (!dyn->settled || !dyn->residual || !dyn->queue || !dyn->queued || !dyn->touched) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    dyn->common = 0.0;
+    dyn->threshold = (tolerance > 0 ? tolerance : TOLERANCE) / N;
+    dyn->head = 0;
+    dyn->count = 0;
+    dyn->edges = 0;
+
+    double dangling = 0.0;
+    for (int i = 0; i < N; i++) {
+        dyn->settled[i] = ranks ? ranks[i] : 1.0 / N;
+        if (graph->adjacencyListsOutLength[i] == 0) dangling += dyn->settled[i];
+    }
+    for (int i = 0; i < N; i++) {
+        double sumA = 0.0;
+        for (node* u = graph->adjacencyListsIn[i]; u != NULL; u = u->next) {
+            sumA += dyn->settled[u->v] / graph->adjacencyListsOutLength[u->v];
+        }
+        dyn->residual[i] = D/N + (1-D) * (sumA + dangling/N) - dyn->settled[i];
+        queueVertex(dyn, i);
+    }
+    settleDynamicRanks(dyn);
+}
+
+// adds sign times what u gives its out-neighbors, or all N when it is dangling, to their residuals
+static void shiftContribution(DynamicRanks* dyn, vertex u, double sign) {
+    Graph* graph = dyn->graph;
+    int degree = graph->adjacencyListsOutLength[u];
+    double mass = sign * (1-D) * dyn->settled[u];
+    if (degree == 0) {
+        dyn->common += mass / graph->numVertices;
+        return;
+    }
+    for (node* w = graph->adjacencyListsOut[u]; w != NULL; w = w->next) {
+        dyn->residual[w->v] += mass / degree;
+        queueVertex(dyn, w->v);
+    }
+    dyn->edges += degree;
+}
+
+/*
+ * Applies a batch to the graph and brings the ranks back to tolerance.
+ * Only the sources of the batch give differently afterwards, so their old
+ * contributions come out of the residuals before the lists change and the
+ * new ones go in after, once per source however many of its edges change.
+ * Removing an edge that isn't there is skipped. Returns the out-edges
+ * pushed along, the shifts included.
+ */
+long updateDynamicRanks(DynamicRanks* dyn, const EdgeUpdate* updates, int count) {
+    long before = dyn->edges;
+    for (int k = 0; k < count; k++) {
+        vertex u = updates[k].source;
+        if (dyn->touched[u]) continue;
+        dyn->touched[u] = 1;
+        shiftContribution(dyn, u, -1.0);
+    }
+    for (int k = 0; k < count; k++) {
+        if (updates[k].insert) {
+            addEdge(dyn->graph, updates[k].source, updates[k].destination);
+        } else {
+            removeEdge(dyn->graph, updates[k].source, updates[k].destination);
+        }
+    }
+    for (int k = 0; k < count; k++) {
+        vertex u = updates[k].source;
+        if (!dyn->touched[u]) continue;
+        dyn->touched[u] = 0;
+        shiftContribution(dyn, u, 1.0);
+    }
+    settleDynamicRanks(dyn);
+    return dyn->edges - before;
+}
+
+void dynamicRanks(DynamicRanks* dyn, float* ranks) {
+    for (unsigned int i = 0; i < dyn->graph->numVertices; i++) {
+        ranks[i] = (float)(dyn->settled[i] + dyn->residual[i] + dyn->common);
+    }
+}
+
+// the graph stays with the caller
+void freeDynamicRanks(DynamicRanks* dyn) {
+    free(dyn->settled);
+    free(dyn->residual);
+    free(dyn->queue);
+    free(dyn->queued);
+    free(dyn->touched);
+}
+
+void help (Graph* graph, float* ranks, float* newRanks, int start, int end, double sumB, int N) {
+    
+    for (int i=start; i < end; i++) {
+        //calculate i rank
+        double sumA = 0.0;
+        node* u = graph->adjacencyListsIn[i];
+        while (u != NULL) {
+            // u->v is the id
+            sumA += ranks[u->v]/graph->adjacencyListsOutLength[u->v];
+            u = u->next;
+        }
+        newRanks[i] = D/N +(1-D)*(sumA+sumB);
+    }
+}
+
+typedef struct __attribute__((aligned(64))) ThreadData {
+    Graph* graph;
+    CSRGraph* csr; // used instead of graph when not NULL
+    float* ranks;
+    float* newRanks;
+    float* contrib; // KERNEL_CONTRIB, NULL divides per edge
+    PullKernel pull; // KERNEL_SIMD, NULL sums in pullSum
+    int start;
+    int end;
+    double sumB;
+    int N;
+    // residual of this block, reduced by the main thread
+    double l1;
+    double linf;
+    // inputs of the next iteration, produced while this block's ranks are hot
+    float* nextContrib; // NULL when contrib is
+    float* invOutDeg;
+    int* dangling; // sorted ids without outlinks
+    int danglingStart; // slice of dangling inside [start, end)
+    int danglingEnd;
+    double danglingSum;
+} ThreadData;
+
+typedef struct Task {
+    ThreadData* data;
+    struct Task* next;
+} Task;
+
+typedef struct TaskQueue {
+    Task* front;
+    Task* back;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+} TaskQueue;
+
+typedef struct ThreadPool {
+    // how many to join
+    int thread_count;
+    int stop;
+    pthread_t* threads;
+    TaskQueue queue;
+    Latch pending; // enqueued tasks not finished yet
+} ThreadPool;
+
+void initQueue (TaskQueue* queue) {
+    queue->front = queue->back = NULL;
+    pthread_mutex_init(&queue->mutex, NULL);
+    pthread_cond_init(&queue->cond, NULL);
+}
+
+void enqueue (ThreadPool* pool, ThreadData* data) {
+    Task* task = malloc(sizeof(Task));
+    task->data = data;
+    task->next = NULL;
+
+    // counted before any worker can finish it
+    latchAdd(&pool->pending, 1);
+
+    pthread_mutex_lock(&pool->queue.mutex);
+    if (pool->queue.back == NULL) {
+        pool->queue.front = pool->queue.back = task;
+    } else {
+        pool->queue.back->next = task;
+        pool->queue.back = task;
+    }
+    pthread_mutex_unlock(&pool->queue.mutex);
+
+    // signal new task
+    pthread_cond_signal(&pool->queue.cond);
+}
+
+ThreadData* dequeue (ThreadPool* pool) {
+
+    pthread_mutex_lock(&pool->queue.mutex);
+    while (pool->queue.front == NULL && !pool->stop) {
+        // wait for available task
+        pthread_cond_wait(&pool->queue.cond, &pool->queue.mutex);
+    }
+
+    if (pool->stop) {
+        // stop here
+        pthread_mutex_unlock(&pool->queue.mutex);
+        return NULL;
+    }
+
+    Task* task = pool->queue.front;
+    pool->queue.front = pool->queue.front->next;
+    if (pool->queue.front == NULL) {
+        pool->queue.back = NULL;
+    }
+    pthread_mutex_unlock(&pool->queue.mutex);
+
+    ThreadData* data = task->data;
+    free(task);
+    return data;
+}
+
+
+// stores the new rank of i, returns how far it moved
+double updateRank(ThreadData* data, int i, double sumA) {
+    float rank = D/data->N +(1-D)*(sumA+data->sumB);
+    double diff = fabs(rank - data->ranks[i]);
+    data->newRanks[i] = rank;
+    return diff;
+}
+
+// sum over the in-neighbors u of i of ranks[u] / outDegree[u]
+double pullSum(ThreadData* data, int i) {
+    double sumA = 0.0;
+    CSRGraph* csr = data->csr;
+
+    if (csr != NULL && data->contrib != NULL) {
+        for (long k = csr->inOffsets[i]; k < csr->inOffsets[i+1]; k++) {
+            sumA += data->contrib[csr->inNeighbors[k]];
+        }
+    } else if (csr != NULL) {
+        for (long k = csr->inOffsets[i]; k < csr->inOffsets[i+1]; k++) {
+            vertex u = csr->inNeighbors[k];
+            sumA += data->ranks[u]/csr->outDegree[u];
+        }
+    } else if (data->contrib != NULL) {
+        for (node* u = data->graph->adjacencyListsIn[i]; u != NULL; u = u->next) {
+            sumA += data->contrib[u->v];
+        }
+    } else {
+        node* u = data->graph->adjacencyListsIn[i];
+        while (u != NULL) {
+            // u->v is the id
+            sumA += data->ranks[u->v]/data->graph->adjacencyListsOutLength[u->v];
+            u = u->next;
+        }
+    }
+    return sumA;
+}
+
+// dangling mass and contributions of the ranks this block just wrote
+static void nextInputs(ThreadData* data) {
+    double dangling = 0.0;
+    for (int k=data->danglingStart; k < data->danglingEnd; k++) {
+        dangling += data->newRanks[data->dangling[k]];
+    }
+    data->danglingSum = dangling;
+    perfLap(PHASE_DANGLING);
+
+    if (data->nextContrib != NULL) {
+        for (int i=data->start; i < data->end; i++) {
+            data->nextContrib[i] = data->newRanks[i] * data->invOutDeg[i];
+        }
+        perfLap(PHASE_CONTRIB);
+    }
+}
+
+void* help2 (ThreadData* data) {
+
+    // sums stay in locals, data is stored to once per block rather than per vertex
+    double l1 = 0.0, linf = 0.0;
+    perfStart();
+
+    if (data->pull != NULL) {
+        data->pull(data->csr, data->contrib, data->ranks, data->newRanks, data->start, data->end,
+                   D/data->N + (1-D)*data->sumB, 1-D, &l1, &linf);
+    } else {
+        for (int i=data->start; i < data->end; i++) {
+            double diff = updateRank(data, i, pullSum(data, i));
+            l1 += diff;
+            if (diff > linf) linf = diff;
+        }
+    }
+
+    data->l1 = l1;
+    data->linf = linf;
+    perfLap(PHASE_UPDATE);
+    if (data->dangling != NULL) nextInputs(data);
+    return NULL;
+}
+
+void* worker_thread (void* arg) {
+    ThreadPool* pool = (ThreadPool*)arg;
+    while (1) {
+        // sleeps thread until task available
+        ThreadData* data = dequeue(pool);
+        if (data == NULL) {
+            break; // error
+        }
+        help2(data);
+        latchCountDown(&pool->pending);
+    }
+    return NULL; // error
+}
+
+void initPool(ThreadPool* pool, int thread_count) {
+    pool->thread_count = thread_count;
+    pool->stop = 0;
+    pool->threads = malloc(thread_count * sizeof(pthread_t));
+    if (!pool->threads) {
+        perror("failed to allocate threads");
+        exit(EXIT_FAILURE);
+    }
+
+    // before the workers start using them
+    initQueue(&pool->queue);
+    initLatch(&pool->pending);
+
+    for (int i=0; i < thread_count; i++) {
+        if (pthread_create(&pool->threads[i], NULL, worker_thread, (void*)pool)) {
+            perror("failed to initialize threads");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+void destroyPool(ThreadPool* pool) {
+    // wait for task to end
+    pthread_mutex_lock(&pool->queue.mutex);
+    pool->stop = 1;
+    // wake sleeping threads to stop
+    pthread_cond_broadcast(&pool->queue.cond);
+    pthread_mutex_unlock(&pool->queue.mutex);
+
+    for (int i=0; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    free(pool->threads);
+    pthread_mutex_destroy(&pool->queue.mutex);
+    pthread_cond_destroy(&pool->queue.cond);
+    destroyLatch(&pool->pending);
+}
+
+// waits until the workers finished every enqueued task, not just dequeued it
+void waitPool(ThreadPool* pool) {
+    latchWait(&pool->pending);
+}
+
+// StealPool task: block t of the ThreadData* array in ctx
+void runBlock(void* ctx, int t) {
+    help2(((ThreadData**)ctx)[t]);
+}
+
+// runs on csr when given, on the linked lists of graph otherwise,
+// conv may be NULL to run a fixed number of iterations
+void runParallelPageRank(Graph *graph, CSRGraph *csr, int kernel, int iterations, float* ranks, Convergence* conv) {
+
+    int N = csr ? (int)csr->numVertices : (int)graph->numVertices;
+    int* outLength = csr ? csr->outDegree : graph->adjacencyListsOutLength;
+    float *newRanks = (float *)malloc(N * sizeof(float));
+
+    float *contrib = NULL, *nextContrib = NULL, *invOutDeg = NULL;
+    if (kernel == KERNEL_CONTRIB || kernel == KERNEL_SIMD) {
+        // double buffered, blocks write the next one while others still read this one
+        contrib = (float *)malloc(N * sizeof(float));
+        nextContrib = (float *)malloc(N * sizeof(float));
+        invOutDeg = inverseOutDegrees(outLength, N);
+    }
+    int danglingCount;
+    int* dangling = danglingList(outLength, N, &danglingCount);
+    // the vector kernels need csr, lists fall back to KERNEL_CONTRIB
+    PullKernel pull = (kernel == KERNEL_SIMD && csr != NULL) ? pullKernel(SIMD_LEVEL) : NULL;
+
+    // calc ceil
+    int task_count = (N+BLOCK_SIZE-1) / BLOCK_SIZE;
+    int* bounds = (int*) malloc((task_count + 1) * sizeof(int));
+    if (BALANCE) {
+        // same number of edges per task, a block of hubs doesn't become the tail
+        partitionByInEdges(graph, csr, task_count, bounds);
+    } else {
+        for (int i=0; i <= task_count; i++) {
+            bounds[i] = (i * BLOCK_SIZE > N) ? N : i * BLOCK_SIZE;
+        }
+    }
+
+    StealPool* pool = createStealPool(threadCount, task_count);
+
+    // descriptors live for the whole run, only ranks and sumB change per iteration
+    // aligned so the partial sums of neighbouring blocks don't share a line
+    ThreadData** data = malloc(task_count * sizeof(ThreadData*));
+    for (int i=0; i < task_count; i++) {
+        data[i] = (ThreadData*) aligned_alloc(64, sizeof(ThreadData));
+        data[i]->graph=graph; data[i]->csr=csr; data[i]->pull=pull; data[i]->N=N;
+        data[i]->start = bounds[i]; data[i]->end = bounds[i+1];
+        data[i]->invOutDeg = invOutDeg; data[i]->dangling = dangling;
+        data[i]->danglingStart = danglingLowerBound(dangling, danglingCount, bounds[i]);
+        data[i]->danglingEnd = danglingLowerBound(dangling, danglingCount, bounds[i+1]);
+    }
+
+    float* out = ranks;
+    startRanks(ranks, N, conv);
+    double waitTime = 0.0;
+
+    // only the first iteration's inputs are computed here, blocks produce the rest
+    double sumB = 0.0;
+    for (int k=0; k < danglingCount; k++) sumB += ranks[dangling[k]];
+    sumB /= N;
+    if (contrib != NULL) {
+        for (int i=0; i < N; i++) contrib[i] = ranks[i] * invOutDeg[i];
+    }
+
+    for (int iter = 0; iter < iterations; iter++) {
+
+        for (int i=0; i < task_count; i++) {
+            data[i]->ranks=ranks; data[i]->newRanks=newRanks; data[i]->sumB=sumB;
+            data[i]->contrib=contrib; data[i]->nextContrib=nextContrib;
+        }
+
+        // returns once every block is done
+        double waitStart = wallTime();
+        runTasks(pool, task_count, runBlock, data);
+        waitTime += wallTime() - waitStart;
+
+        // reduce the block residuals and the dangling mass of the ranks just written
+        perfStart();
+        double l1 = 0.0, linf = 0.0;
+        sumB = 0.0;
+        for (int i=0; i < task_count; i++) {
+            l1 += data[i]->l1;
+            if (data[i]->linf > linf) linf = data[i]->linf;
+            sumB += data[i]->danglingSum;
+        }
+        sumB /= N;
+
+        // pointer swapping instead of assignment
+        float* temp = ranks;
+        ranks = newRanks; 
+        newRanks = temp;
+        temp = contrib;
+        contrib = nextContrib;
+        nextContrib = temp;
+        perfLap(PHASE_SWAP);
+
+        if (recordIteration(conv, iter, l1, linf, ranks, N)) break;
+    }
+
+    if (REPORT_BALANCE) {
+        long minEdges = -1, maxEdges = 0, total = 0;
+        for (int i=0; i < task_count; i++) {
+            long edges = 0;
+            for (int v = bounds[i]; v < bounds[i+1]; v++) {
+                edges += csr ? csr->inOffsets[v+1] - csr->inOffsets[v] : graph->adjacencyListsInLength[v];
+            }
+            total += edges;
+            if (minEdges < 0 || edges < minEdges) minEdges = edges;
+            if (edges > maxEdges) maxEdges = edges;
+        }
+        printf("%d tasks, edges per task min %ld avg %ld max %ld, waited %lf s for them\n",
+               task_count, minEdges, total / task_count, maxEdges, waitTime);
+    }
+
+    // an odd number of swaps leaves the result in our buffer
+    if (ranks != out) {
+        memcpy(out, ranks, N * sizeof(float));
+        newRanks = ranks;
+    }
+
+    destroyStealPool(pool);
+    for (int i=0; i < task_count; i++) free(data[i]);
+    free(data);
+    free(bounds);
+    free(dangling);
+    free(contrib);
+    free(nextContrib);
+    free(invOutDeg);
+    free(newRanks);
+}
+
+void ParallelPageRank(Graph *graph, int iterations, float* ranks) {
+    runParallelPageRank(graph, NULL, KERNEL_DIVIDE, iterations, ranks, NULL);
+}
+
+void ParallelPageRankCSR(CSRGraph *csr, int iterations, float* ranks) {
+    runParallelPageRank(NULL, csr, KERNEL_DIVIDE, iterations, ranks, NULL);
+}
+
+// about M edges without self loops, generated on threadCount threads
+void generateRandomGraph(Graph* graph, int N, int M) {
+    EdgeList* edges = generateErdosRenyi(N, M, SEED, threadCount);
+    for (long e = 0; e < edges->numEdges; e++) {
+        addEdge(graph, edges->src[e], edges->dst[e]);
+    }
+    freeEdgeList(edges);
+}
+
+// edges per second of each generator, and whether one thread gives the same list
+void benchmarkGenerators(int N, long M) {
+    const char* names[] = {"erdos-renyi", "r-mat", "barabasi-albert"};
+    for (int g = 0; g < 3; g++) {
+        EdgeList* edges[2];
+        double time = 0.0;
+        for (int run = 0; run < 2; run++) {
+            int threads = run ? 1 : threadCount;
+            double start = wallTime();
+            if (g == 0) edges[run] = generateErdosRenyi(N, M, SEED, threads);
+            else if (g == 1) edges[run] = generateRMAT(N, M, RMAT_A, RMAT_B, RMAT_C, SEED, threads);
+            else edges[run] = generateBarabasiAlbert(N, (int)(M / N), SEED, threads);
+            if (run == 0) time = wallTime() - start;
+        }
+        long m = edges[0]->numEdges;
+        int same = m == edges[1]->numEdges &&
+                   memcmp(edges[0]->src, edges[1]->src, m * sizeof(vertex)) == 0 &&
+                   memcmp(edges[0]->dst, edges[1]->dst, m * sizeof(vertex)) == 0;
+        printf("%-16s %ld edges in %.3lf s (%.1lf M edges/s), 1 thread gives %s list\n",
+               names[g], m, time, m / time * 1e-6, same ? "the same" : "a different");
+        freeEdgeList(edges[0]);
+        freeEdgeList(edges[1]);
+    }
+}
+
+// per edge cost of dividing in the edge loop against gathering contrib
+void benchmarkEdgeCost(int N, int M, int iterations) {
+    Graph *graph = createArenaGraph(N);
+    generateRandomGraph(graph, N, M);
+    CSRGraph *csr = createCSRGraph(graph);
+    float *ranks = (float *)malloc(N * sizeof(float));
+    double edges = (double)csr->numEdges * iterations;
+
+    double start = wallTime();
+    GoodPageRankCSR(csr, iterations, ranks);
+    double divide = wallTime() - start;
+
+    start = wallTime();
+    GoodPageRankContrib(csr, iterations, ranks, NULL);
+    double contrib = wallTime() - start;
+
+    printf("per edge (N=%d, M=%ld): divide %.3lf ns, contrib %.3lf ns",
+           N, csr->numEdges, divide * 1e9 / edges, contrib * 1e9 / edges);
+
+    for (int level = SIMD_AVX2; level <= simdLevel(); level++) {
+        start = wallTime();
+        GoodPageRankSIMD(csr, level, iterations, ranks, NULL);
+        double simd = wallTime() - start;
+        printf(", %s %.3lf ns", simdLevelName(level), simd * 1e9 / edges);
+    }
+    printf("\n");
+
+    free(ranks);
+    freeCSRGraph(csr);
+    freeGraph(graph);
+}
+
+// sweeps and wall time to TOLERANCE of the in-place engines against
+// GoodPageRank, and against GoodPageRankContrib on the same csr
+void benchmarkGaussSeidel(int N, int M, int iterations) {
+    static const char* names[] = {"good", "contrib", "gauss-seidel", "async"};
+    Graph *graph = createArenaGraph(N);
+    generateRandomGraph(graph, N, M);
+    CSRGraph *csr = createCSRGraph(graph);
+    float *expected = (float *)malloc(N * sizeof(float));
+    float *ranks = (float *)malloc(N * sizeof(float));
+    Convergence conv;
+    initConvergence(&conv, TOLERANCE, NORM_L1, iterations);
+    // every engine stops somewhere within the tolerance of the fixed point
+    Tolerance tol;
+    initTolerance(&tol);
+    tol.maxRel = SIMD_TOLERANCE;
+    VerifyResult result;
+
+    printf("to L1 %.0e (N=%d, M=%ld), async on %d threads\n", TOLERANCE, N, csr->numEdges, threadCount);
+    printf("%-13s %10s %9s %12s %10s  %s\n", "engine", "iterations", "time s", "residual", "x contrib", "ranks");
+    double contrib = 0.0;
+    for (int engine = 0; engine < 4; engine++) {
+        float* out = engine == 0 ? expected : ranks;
+        double start = wallTime();
+        switch (engine) {
+        case 0: GoodPageRankConverge(graph, iterations, out, &conv); break;
+        case 1: GoodPageRankContrib(csr, iterations, out, &conv); break;
+        case 2: GaussSeidelPageRank(csr, iterations, out, &conv); break;
+        case 3: AsyncPageRank(csr, iterations, out, &conv); break;
+        }
+        double t = wallTime() - start;
+        if (engine == 1) contrib = t;
+        printf("%-13s %10d %9.4lf %12e", names[engine], conv.iterations, t, lastResidual(&conv));
+        if (engine == 0) {
+            printf("\n");
+            continue;
+        }
+        verifyRanks(expected, ranks, N, &tol, &result);
+        printf(" %9.2lfx  \e[1m%s\e[m, max rel %.2e\n", contrib / t, result.pass ? "equal" : "different",
+               result.maxRel);
+    }
+
+    freeConvergence(&conv);
+    free(expected);
+    free(ranks);
+    freeCSRGraph(csr);
+    freeGraph(graph);
+}
+
+// building through addEdge against mapping a graph file written from the result
+void benchmarkGraphFile(int N, int M, int iterations) {
+    double start = wallTime();
+    Graph *graph = createArenaGraph(N);
+    generateRandomGraph(graph, N, M);
+    CSRGraph *csr = createCSRGraph(graph);
+    double build = wallTime() - start;
+
+    start = wallTime();
+    if (writeCSRGraphFile(GRAPH_FILE_BENCH, csr) != 0) {
+        freeCSRGraph(csr);
+        freeGraph(graph);
+        return;
+    }
+    double write = wallTime() - start;
+
+    int flags[] = {0, GRAPH_MAP_POPULATE, GRAPH_MAP_POPULATE | GRAPH_MAP_VERIFY};
+    const char *names[] = {"map", "populate", "verify"};
+    printf("graph file (N=%d, M=%ld): build %.3lf s, write %.3lf s", N, csr->numEdges, build, write);
+    for (int i = 0; i < 3; i++) {
+        start = wallTime();
+        CSRGraph *mapped = mapCSRGraphFile(GRAPH_FILE_BENCH, flags[i]);
+        double map = wallTime() - start;
+        if (mapped == NULL) break;
+        printf(", %s %.3lf ms", names[i], map * 1e3);
+        freeCSRGraph(mapped);
+    }
+    printf("\n");
+
+    // the mapped arrays are the built ones, so the ranks are too
+    float *ranks = (float *)malloc(N * sizeof(float));
+    float *mappedRanks = (float *)malloc(N * sizeof(float));
+    CSRGraph *mapped = mapCSRGraphFile(GRAPH_FILE_BENCH, GRAPH_MAP_WILLNEED);
+    if (mapped != NULL) {
+        GoodPageRankContrib(csr, iterations, ranks, NULL);
+        GoodPageRankContrib(mapped, iterations, mappedRanks, NULL);
+        printf("ranks on the mapped graph are \e[1m%s\e[m\n",
+               memcmp(ranks, mappedRanks, N * sizeof(float)) == 0 ? "identical" : "different");
+        freeCSRGraph(mapped);
+    }
+    unlink(GRAPH_FILE_BENCH);
+
+    free(ranks);
+    free(mappedRanks);
+    freeCSRGraph(csr);
+    freeGraph(graph);
+}
+
+// tasks per second through the mutex queue and the work stealing pool
+static void timePools(const char* name, ThreadData** blocks, int task_count, int rounds) {
+    ThreadPool* queue = (ThreadPool*) malloc(sizeof(ThreadPool));
+    initPool(queue, threadCount);
+    double start = wallTime();
+    for (int r=0; r < rounds; r++) {
+        for (int i=0; i < task_count; i++) enqueue(queue, blocks[i]);
+        waitPool(queue);
+    }
+    double queueTime = wallTime() - start;
+    destroyPool(queue);
+    free(queue);
+
+    StealPool* pool = createStealPool(threadCount, task_count);
+    start = wallTime();
+    for (int r=0; r < rounds; r++) {
+        runTasks(pool, task_count, runBlock, blocks);
+    }
+    double stealTime = wallTime() - start;
+    long tasksRun, steals;
+    getStealStats(pool, &tasksRun, &steals);
+    destroyStealPool(pool);
+
+    double tasks = (double)task_count * rounds;
+    printf("pool throughput, %s (%d tasks x %d rounds, %d threads): queue %.0lf tasks/s, "
+           "stealing %.0lf tasks/s (%ld steals)\n",
+           name, task_count, rounds, threadCount, tasks / queueTime, tasks / stealTime, steals);
+}
+
+// empty blocks, so only the scheduling is measured, then pull blocks of csr
+// with Zipf sizes: the first worker's contiguous share holds most of the
+// edges and the others run out of tasks while it is still busy
+void benchmarkPools(CSRGraph* csr, int task_count, int rounds) {
+    int N = csr->numVertices;
+    ThreadData* data = (ThreadData*) aligned_alloc(64, task_count * sizeof(ThreadData));
+    memset(data, 0, task_count * sizeof(ThreadData));
+    ThreadData** blocks = (ThreadData**) malloc(task_count * sizeof(ThreadData*));
+    for (int i=0; i < task_count; i++) {
+        data[i].N = 1;
+        blocks[i] = &data[i];
+    }
+    timePools("empty", blocks, task_count, rounds);
+
+    float* ranks = (float*)malloc(N * sizeof(float));
+    float* newRanks = (float*)malloc(N * sizeof(float));
+    initializeRanks(ranks, N);
+    double harmonic = 0.0;
+    for (int i=0; i < task_count; i++) harmonic += 1.0 / (i + 1);
+    double prefix = 0.0;
+    for (int i=0; i < task_count; i++) {
+        data[i].csr = csr;
+        data[i].ranks = ranks;
+        data[i].newRanks = newRanks;
+        data[i].N = N;
+        data[i].start = (int)(N * prefix / harmonic);
+        prefix += 1.0 / (i + 1);
+        data[i].end = (i == task_count - 1) ? N : (int)(N * prefix / harmonic);
+    }
+    timePools("skewed", blocks, task_count, rounds);
+
+    free(ranks);
+    free(newRanks);
+    free(blocks);
+    free(data);
+}
+
+typedef struct BarrierBench {
+    pthread_barrier_t* pthreadBarrier; // one of the two is set
+    SpinBarrier* spinBarrier;
+    int rounds;
+} BarrierBench;
+
+void* barrierBenchThread(void* arg) {
+    BarrierBench* bench = (BarrierBench*)arg;
+    int sense = 0;
+    for (int r = 0; r < bench->rounds; r++) {
+        if (bench->spinBarrier) spinBarrierWait(bench->spinBarrier, &sense);
+        else pthread_barrier_wait(bench->pthreadBarrier);
+    }
+    return NULL;
+}
+
+// seconds per barrier round with threads threads crossing it rounds times
+double timeBarrier(BarrierBench* bench, int threads) {
+    pthread_t* tids = malloc(threads * sizeof(pthread_t));
+    double start = wallTime();
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&tids[i], NULL, barrierBenchThread, bench)) {
+            perror("failed to create thread");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (int i = 0; i < threads; i++) pthread_join(tids[i], NULL);
+    double elapsed = wallTime() - start;
+    free(tids);
+    return elapsed / bench->rounds;
+}
+
+// round trip latency of the pthread barrier against SpinBarrier, as main2.c uses them
+void benchmarkBarriers(int maxThreads, int rounds) {
+    printf("threads  pthread barrier (us)  spin barrier (us)\n");
+    for (int threads = 2; threads <= maxThreads; threads *= 2) {
+        pthread_barrier_t pb;
+        pthread_barrier_init(&pb, NULL, threads);
+        BarrierBench bench = { &pb, NULL, rounds };
+        double pthreadTime = timeBarrier(&bench, threads);
+        pthread_barrier_destroy(&pb);
+
+        SpinBarrier sb;
+        initSpinBarrier(&sb, threads);
+        bench.pthreadBarrier = NULL;
+        bench.spinBarrier = &sb;
+        double spinTime = timeBarrier(&bench, threads);
+        destroySpinBarrier(&sb);
+
+        printf("%7d  %20.3lf  %17.3lf\n", threads, pthreadTime * 1e6, spinTime * 1e6);
+    }
+}
+
+// runs the parallel engine again and again against GoodPageRank, a block
+// still running when the ranks are swapped shows up as a mismatch
+int stressParallel(Graph* graph, CSRGraph* csr, int iterations, int runs) {
+    int N = graph->numVertices;
+    float *expected = (float *)malloc(N * sizeof(float));
+    float *ranks = (float *)malloc(N * sizeof(float));
+    GoodPageRank(graph, iterations, expected);
+
+    Tolerance tol;
+    initTolerance(&tol);
+    tol.maxRel = SIMD_TOLERANCE;
+    VerifyResult result;
+
+    int passed = 0;
+    for (int run = 0; run < runs; run++) {
+        int kernel = run % 3;
+        runParallelPageRank(run % 2 ? graph : NULL, run % 2 ? NULL : csr, kernel, iterations, ranks, NULL);
+
+        if (verifyRanks(expected, ranks, N, &tol, &result)) passed++;
+        else printf("stress run %d (kernel %d) max relative error %e\n", run, kernel, result.maxRel);
+    }
+    printf("stress: %d of %d parallel runs match good\n", passed, runs);
+
+    free(ranks);
+    free(expected);
+    return passed == runs;
+}
+
+// one run of a PageRank variant for the harness
+typedef struct VariantRun {
+    Graph* graph;
+    CSRGraph* csr;
+    int iterations;
+    float* ranks;
+    int variant; // VARIANT_*, index into variantNames
+} VariantRun;
+
+enum {
+    VARIANT_GOOD, VARIANT_PARALLEL, VARIANT_GOOD_CSR, VARIANT_PARALLEL_CSR,
+    VARIANT_CONTRIB, VARIANT_SIMD, VARIANT_PARALLEL_CONTRIB, VARIANT_PARALLEL_SIMD,
+    VARIANTS
+};
+
+static const char* variantNames[VARIANTS] = {
+    "good", "parallel", "good-csr", "parallel-csr",
+    "contrib", "simd", "parallel-contrib", "parallel-simd",
+};
+
+void runVariant(void* ctx) {
+    VariantRun* v = (VariantRun*)ctx;
+    switch (v->variant) {
+    case VARIANT_GOOD: GoodPageRank(v->graph, v->iterations, v->ranks); break;
+    case VARIANT_PARALLEL: ParallelPageRank(v->graph, v->iterations, v->ranks); break;
+    case VARIANT_GOOD_CSR: GoodPageRankCSR(v->csr, v->iterations, v->ranks); break;
+    case VARIANT_PARALLEL_CSR: ParallelPageRankCSR(v->csr, v->iterations, v->ranks); break;
+    case VARIANT_CONTRIB: GoodPageRankContrib(v->csr, v->iterations, v->ranks, NULL); break;
+    case VARIANT_SIMD: GoodPageRankSIMD(v->csr, SIMD_LEVEL, v->iterations, v->ranks, NULL); break;
+    case VARIANT_PARALLEL_CONTRIB:
+        runParallelPageRank(NULL, v->csr, KERNEL_CONTRIB, v->iterations, v->ranks, NULL); break;
+    case VARIANT_PARALLEL_SIMD:
+        runParallelPageRank(NULL, v->csr, KERNEL_SIMD, v->iterations, v->ranks, NULL); break;
+    }
+}
+
+// every variant for a fixed number of iterations against the serial list engine; the naive
+// PageRank is O(N^2) per iteration and is left out so the speedups are against a real baseline
+void benchmarkVariants(Graph* graph, CSRGraph* csr, int iterations) {
+    Bench bench;
+    initBench(&bench, "pagerank", BENCH_WARMUPS, BENCH_REPS);
+    VariantRun v = {graph, csr, iterations, (float*)malloc(csr->numVertices * sizeof(float)), VARIANT_GOOD};
+    double edges = (double)csr->numEdges * iterations;
+
+    for (v.variant = VARIANT_GOOD; v.variant < VARIANTS; v.variant++) {
+        benchRun(&bench, variantNames[v.variant], runVariant, &v, edges, "edges");
+    }
+    writeBenchCSV(&bench, BENCH_CSV);
+    writeBenchJSON(&bench, BENCH_JSON);
+
+    free(v.ranks);
+    freeBench(&bench);
+}
+
+// strong scaling sizes and average degrees, every pair is one graph
+static const int sweepSizes[] = {100000, 500000};
+static const int sweepDegrees[] = {4, 16};
+// the engines that use threadCount
+static const int parallelVariants[] = {
+    VARIANT_PARALLEL, VARIANT_PARALLEL_CSR, VARIANT_PARALLEL_CONTRIB, VARIANT_PARALLEL_SIMD,
+};
+#define PARALLEL_VARIANTS 4
+
+// median seconds of every parallel variant on threads workers
+static void timeParallelVariants(Graph* graph, CSRGraph* csr, int threads, double* seconds) {
+    Bench bench;
+    initBench(&bench, "sweep", BENCH_WARMUPS, SWEEP_REPS);
+    bench.quiet = 1;
+    VariantRun v = {graph, csr, SWEEP_ITERATIONS, (float*)malloc(csr->numVertices * sizeof(float)), VARIANT_PARALLEL};
+
+    threadCount = threads;
+    for (int k = 0; k < PARALLEL_VARIANTS; k++) {
+        v.variant = parallelVariants[k];
+        seconds[k] = benchRun(&bench, variantNames[v.variant], runVariant, &v, 0, NULL)->median;
+    }
+    threadCount = T;
+
+    free(v.ranks);
+    freeBench(&bench);
+}
+
+// strong: speedup T(1)/T(p), efficiency speedup/p; weak: efficiency T(1)/T(p), speedup p times that
+static void printScalingRow(FILE* csv, const char* mode, CSRGraph* csr, int threads, double* seconds, double* base) {
+    printf("%-6s %8u %9ld %3d", mode, csr->numVertices, csr->numEdges, threads);
+    for (int k = 0; k < PARALLEL_VARIANTS; k++) {
+        double ratio = base[k] / seconds[k];
+        double speedup = (mode[0] == 's') ? ratio : ratio * threads;
+        double efficiency = speedup / threads;
+        printf("  %8.4lf %5.2lfx %4.0lf%%", seconds[k], speedup, 100 * efficiency);
+        if (csv) {
+            fprintf(csv, "%s,%s,%u,%ld,%d,%.9f,%.4f,%.4f\n", mode, variantNames[parallelVariants[k]],
+                    csr->numVertices, csr->numEdges, threads, seconds[k], speedup, efficiency);
+        }
+    }
+    printf("\n");
+}
+
+// threads minThreads, 2 minThreads .. maxThreads on one graph, base is set by the 1 thread run
+static void sweepGraph(FILE* csv, const char* mode, int n, long m, int minThreads, int maxThreads, double* base) {
+    EdgeList* edges = generateErdosRenyi(n, m, SEED, 0);
+    Graph* graph = edgeListToGraph(edges);
+    CSRGraph* csr = edgeListToCSR(edges);
+    freeEdgeList(edges);
+
+    double seconds[PARALLEL_VARIANTS];
+    for (int threads = minThreads; threads <= maxThreads; threads *= 2) {
+        timeParallelVariants(graph, csr, threads, seconds);
+        if (threads == 1) memcpy(base, seconds, sizeof(seconds));
+        printScalingRow(csv, mode, csr, threads, seconds, base);
+    }
+
+    freeCSRGraph(csr);
+    freeGraph(graph);
+}
+
+// every parallel engine over 1, 2, 4 .. maxThreads threads, strong then weak scaling
+void sweep(int maxThreads) {
+    FILE* csv = fopen(SWEEP_CSV, "w");
+    if (!csv) perror(SWEEP_CSV);
+    else fprintf(csv, "mode,variant,vertices,edges,threads,median_s,speedup,efficiency\n");
+
+    printf("%-6s %8s %9s %3s", "mode", "vertices", "edges", "thr");
+    for (int k = 0; k < PARALLEL_VARIANTS; k++) printf("  %-25s", variantNames[parallelVariants[k]]);
+    printf("\n");
+
+    double base[PARALLEL_VARIANTS];
+    for (size_t s = 0; s < sizeof(sweepSizes) / sizeof(sweepSizes[0]); s++) {
+        for (size_t d = 0; d < sizeof(sweepDegrees) / sizeof(sweepDegrees[0]); d++) {
+            sweepGraph(csv, "strong", sweepSizes[s], (long)sweepSizes[s] * sweepDegrees[d], 1, maxThreads, base);
+        }
+    }
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        int n = SWEEP_WEAK_N * threads;
+        sweepGraph(csv, "weak", n, (long)n * SWEEP_WEAK_DEGREE, threads, threads, base);
+    }
+
+    if (csv) fclose(csv);
+}
+
+// splitmix64 finalizer, value k of the update stream
+static unsigned long updateHash(unsigned long k) {
+    k += 0x9e3779b97f4a7c15UL;
+    k = (k ^ (k >> 30)) * 0xbf58476d1ce4e5b9UL;
+    k = (k ^ (k >> 27)) * 0x94d049bb133111ebUL;
+    return k ^ (k >> 31);
+}
+
+// points count edges picked by seed at other vertices, the next day's graph of a crawl
+static void redirectEdges(EdgeList* edges, long count, unsigned long seed) {
+    for (long k = 0; k < count && edges->numEdges > 0; k++) {
+        long e = (long)(updateHash(seed + 2 * k) % edges->numEdges);
+        vertex v = (vertex)(updateHash(seed + 2 * k + 1) % edges->numVertices);
+        if (v != edges->src[e]) edges->dst[e] = v;
+    }
+}
+
+// one engine of benchmarkDelta, edges against pull, what contrib needed from scratch
+static void printDeltaRow(const char* engine, Convergence* conv, double edges, double pull, double seconds,
+                          const float* expected, const float* ranks, int N) {
+    printf("%-17s %10d %12.0lf %9.2lf %9.4lf", engine, conv->iterations, edges, edges / pull, seconds);
+    if (ranks != expected) {
+        Tolerance tol;
+        initTolerance(&tol);
+        tol.maxRel = SIMD_TOLERANCE;
+        VerifyResult result;
+        verifyRanks(expected, ranks, N, &tol, &result);
+        printf("  \e[1m%s\e[m, max rel %.2e", result.pass ? "equal" : "different", result.maxRel);
+    }
+    printf("\n");
+}
+
+// redirected edges of the warm runs, each on the graph as loaded
+static const long deltaChanges[] = {1, 100, 10000};
+
+// edges processed and wall time to TOLERANCE of the push engine against the pull ones, from scratch,
+// then warm from the push engine's ranks once a few edges change, which leaves residuals only near them
+void benchmarkDelta(const char* name, EdgeList* edges, int iterations) {
+    int N = edges->numVertices;
+    float* expected = (float*)malloc(N * sizeof(float));
+    float* ranks = (float*)malloc(N * sizeof(float));
+    float* before = (float*)malloc(N * sizeof(float));
+    vertex* dst = (vertex*)malloc((edges->numEdges + 1) * sizeof(vertex));
+    if (!expected || !ranks || !before || !dst) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    memcpy(dst, edges->dst, edges->numEdges * sizeof(vertex));
+    Convergence conv;
+    initConvergence(&conv, TOLERANCE, NORM_L1, iterations);
+    CSRGraph* csr = edgeListToCSR(edges);
+
+    printf("\n%s, %u vertices, %ld edges, to L1 %.0e, %d threads\n", name, csr->numVertices, csr->numEdges,
+           TOLERANCE, threadCount);
+    printf("%-17s %10s %12s %9s %9s  %s\n", "engine", "iterations", "edges", "x contrib", "time s", "ranks");
+    double start = wallTime();
+    GoodPageRankContrib(csr, iterations, expected, &conv);
+    double t = wallTime() - start;
+    double pull = (double)csr->numEdges * conv.iterations;
+    printDeltaRow("contrib", &conv, pull, pull, t, expected, expected, N);
+
+    start = wallTime();
+    runParallelPageRank(NULL, csr, KERNEL_CONTRIB, iterations, ranks, &conv);
+    t = wallTime() - start;
+    printDeltaRow("parallel-contrib", &conv, (double)csr->numEdges * conv.iterations, pull, t, expected, ranks, N);
+
+    // the first dense pull that seeds the residuals is counted in edges, not in iterations
+    start = wallTime();
+    long pushed = DeltaPageRank(csr, iterations, before, &conv);
+    t = wallTime() - start;
+    printDeltaRow("delta", &conv, pushed, pull, t, expected, before, N);
+    freeCSRGraph(csr);
+
+    for (size_t c = 0; c < sizeof(deltaChanges) / sizeof(deltaChanges[0]); c++) {
+        redirectEdges(edges, deltaChanges[c], SEED);
+        csr = edgeListToCSR(edges);
+        printf("%ld edges redirected, warm runs start from the delta ranks\n", deltaChanges[c]);
+
+        warmStart(&conv, NULL, 0);
+        start = wallTime();
+        GoodPageRankContrib(csr, iterations, expected, &conv);
+        t = wallTime() - start;
+        pull = (double)csr->numEdges * conv.iterations;
+        printDeltaRow("contrib", &conv, pull, pull, t, expected, expected, N);
+
+        warmStart(&conv, before, 0);
+        start = wallTime();
+        GoodPageRankContrib(csr, iterations, ranks, &conv);
+        t = wallTime() - start;
+        printDeltaRow("contrib warm", &conv, (double)csr->numEdges * conv.iterations, pull, t, expected, ranks, N);
+
+        start = wallTime();
+        pushed = DeltaPageRank(csr, iterations, ranks, &conv);
+        t = wallTime() - start;
+        printDeltaRow("delta warm", &conv, pushed, pull, t, expected, ranks, N);
+
+        freeCSRGraph(csr);
+        memcpy(edges->dst, dst, edges->numEdges * sizeof(vertex));
+    }
+
+    freeConvergence(&conv);
+    free(dst);
+    free(before);
+    free(expected);
+    free(ranks);
+}
+
+static const int updateBatchSizes[] = {1, 10, 100, 1000, 10000};
+
+// latency of updateDynamicRanks per batch against rebuilding the csr and iterating from scratch
+void benchmarkDynamic(const char* name, Graph* graph, int iterations) {
+    int N = graph->numVertices;
+    int sizes = sizeof(updateBatchSizes) / sizeof(updateBatchSizes[0]);
+    float* expected = (float*)malloc(N * sizeof(float));
+    float* ranks = (float*)malloc(N * sizeof(float));
+    EdgeUpdate* updates = (EdgeUpdate*)malloc(updateBatchSizes[sizes-1] * sizeof(EdgeUpdate));
+    if (!expected || !ranks || !updates) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    Convergence conv;
+    initConvergence(&conv, TOLERANCE, NORM_L1, iterations);
+    Tolerance tol;
+    initTolerance(&tol);
+    tol.maxRel = SIMD_TOLERANCE;
+    VerifyResult result;
+
+    // warm start from a full run, as a service would after loading the graph
+    CSRGraph* csr = createCSRGraph(graph);
+    GoodPageRankContrib(csr, iterations, expected, &conv);
+    freeCSRGraph(csr);
+    DynamicRanks dyn;
+    double start = wallTime();
+    initDynamicRanks(&dyn, graph, expected, TOLERANCE);
+    printf("\n%s, %u vertices, to L1 %.0e, warm start in %.4lf s pushing %ld edges\n", name, graph->numVertices,
+           TOLERANCE, wallTime() - start, dyn.edges);
+    printf("%8s %12s %12s %10s %9s  %s\n", "batch", "latency ms", "edges", "full s", "x faster", "ranks");
+
+    // half insertions between random vertices, half removals of the first out-edge of random ones
+    unsigned long k = SEED;
+    for (int b = 0; b < sizes; b++) {
+        int count = updateBatchSizes[b];
+        for (int j = 0; j < count; j++) {
+            EdgeUpdate* update = &updates[j];
+            update->insert = (j & 1) == 0;
+            do {
+                update->source = (vertex)(updateHash(k++) % N);
+            } while (!update->insert && graph->adjacencyListsOut[update->source] == NULL);
+            if (update->insert) {
+                do {
+                    update->destination = (vertex)(updateHash(k++) % N);
+                } while (update->destination == update->source);
+            } else {
+                update->destination = graph->adjacencyListsOut[update->source]->v;
+            }
+        }
+
+        start = wallTime();
+        long edges = updateDynamicRanks(&dyn, updates, count);
+        double latency = wallTime() - start;
+        dynamicRanks(&dyn, ranks);
+
+        start = wallTime();
+        csr = createCSRGraph(graph);
+        GoodPageRankContrib(csr, iterations, expected, &conv);
+        double full = wallTime() - start;
+        freeCSRGraph(csr);
+        verifyRanks(expected, ranks, N, &tol, &result);
+        printf("%8d %12.3lf %12ld %10.4lf %9.1lf  \e[1m%s\e[m, max rel %.2e\n", count, latency * 1e3, edges, full,
+               full / latency, result.pass ? "equal" : "different", result.maxRel);
+    }
+
+    freeDynamicRanks(&dyn);
+    freeConvergence(&conv);
+    free(updates);
+    free(ranks);
+    free(expected);
+}
+
+static void printCheckpointRow(const char* run, const char* iterations, double seconds, long edges,
+                               float* expected, float* ranks, int N) {
+    Tolerance tol;
+    initTolerance(&tol);
+    tol.maxRel = SIMD_TOLERANCE;
+    VerifyResult result;
+    verifyRanks(expected, ranks, N, &tol, &result);
+    printf("%-24s %10s %9.4lf %12ld  \e[1m%s\e[m, max rel %.2e\n", run, iterations, seconds, edges,
+           result.pass ? "equal" : "different", result.maxRel);
+}
+
+/*
+ * A run cut off after CHECKPOINT_PREEMPT iterations and resumed from its
+ * checkpoint against one that ran through, then the next day's graph, with
+ * CHECKPOINT_CHANGE edges per million pointing elsewhere, from the uniform
+ * vector and from the day before's checkpoint. edges is changed in place.
+ */
+void benchmarkCheckpoint(const char* name, EdgeList* edges, int iterations) {
+    int N = edges->numVertices;
+    float* expected = (float*)malloc(N * sizeof(float));
+    float* ranks = (float*)malloc(N * sizeof(float));
+    if (!expected || !ranks) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    char count[32];
+    Convergence conv;
+    CSRGraph* csr = edgeListToCSR(edges);
+    printf("\n%s, %u vertices, %ld edges, to L1 %.0e, checkpoint every %d iterations\n", name,
+           csr->numVertices, csr->numEdges, TOLERANCE, CHECKPOINT_INTERVAL);
+    printf("%-24s %10s %9s %12s  %s\n", "run", "iterations", "time s", "edges", "ranks");
+
+    initConvergence(&conv, TOLERANCE, NORM_L1, iterations);
+    double start = wallTime();
+    GoodPageRankContrib(csr, iterations, expected, &conv);
+    snprintf(count, sizeof(count), "%d", conv.iterations);
+    printCheckpointRow("through", count, wallTime() - start, csr->numEdges * conv.iterations, expected, expected, N);
+    freeConvergence(&conv);
+
+    // maxIterations stands in for the kill, the run before it wrote every CHECKPOINT_INTERVAL
+    initConvergence(&conv, TOLERANCE, NORM_L1, CHECKPOINT_PREEMPT);
+    setCheckpoint(&conv, CHECKPOINT_FILE, CHECKPOINT_INTERVAL);
+    start = wallTime();
+    GoodPageRankContrib(csr, CHECKPOINT_PREEMPT, ranks, &conv);
+    freeConvergence(&conv);
+    CheckpointHeader header;
+    float* saved = readCheckpoint(CHECKPOINT_FILE, &header);
+    if (saved == NULL || header.numVertices != (uint64_t)N) {
+        free(saved);
+        freeCSRGraph(csr);
+        free(ranks);
+        free(expected);
+        return;
+    }
+    initConvergence(&conv, TOLERANCE, NORM_L1, iterations - (int)header.iteration);
+    warmStart(&conv, saved, header.iteration);
+    setCheckpoint(&conv, CHECKPOINT_FILE, CHECKPOINT_INTERVAL);
+    GoodPageRankContrib(csr, iterations - (int)header.iteration, ranks, &conv);
+    snprintf(count, sizeof(count), "%ld + %d", (long)header.iteration, conv.iterations);
+    printCheckpointRow("cut off and resumed", count, wallTime() - start,
+                       csr->numEdges * (header.iteration + conv.iterations), expected, ranks, N);
+    freeConvergence(&conv);
+    free(saved);
+    freeCSRGraph(csr);
+
+    // the converged vector of today is the start of tomorrow
+    float* yesterday = readCheckpoint(CHECKPOINT_FILE, &header);
+    unlink(CHECKPOINT_FILE);
+    if (yesterday == NULL) {
+        free(ranks);
+        free(expected);
+        return;
+    }
+    long changed = edges->numEdges * CHECKPOINT_CHANGE / 1000000;
+    redirectEdges(edges, changed, SEED);
+    csr = edgeListToCSR(edges);
+    printf("next day, %ld edges redirected\n", changed);
+
+    initConvergence(&conv, TOLERANCE, NORM_L1, iterations);
+    start = wallTime();
+    GoodPageRankContrib(csr, iterations, expected, &conv);
+    snprintf(count, sizeof(count), "%d", conv.iterations);
+    printCheckpointRow("contrib cold", count, wallTime() - start, csr->numEdges * conv.iterations, expected,
+                       expected, N);
+    warmStart(&conv, yesterday, header.iteration);
+    start = wallTime();
+    GoodPageRankContrib(csr, iterations, ranks, &conv);
+    snprintf(count, sizeof(count), "%d", conv.iterations);
+    printCheckpointRow("contrib warm", count, wallTime() - start, csr->numEdges * conv.iterations, expected,
+                       ranks, N);
+
+    // the push engine only pays for the residuals the changes leave
+    warmStart(&conv, NULL, 0);
+    start = wallTime();
+    long pushed = DeltaPageRank(csr, iterations, ranks, &conv);
+    snprintf(count, sizeof(count), "%d", conv.iterations);
+    printCheckpointRow("delta cold", count, wallTime() - start, pushed, expected, ranks, N);
+    warmStart(&conv, yesterday, header.iteration);
+    start = wallTime();
+    pushed = DeltaPageRank(csr, iterations, ranks, &conv);
+    snprintf(count, sizeof(count), "%d", conv.iterations);
+    printCheckpointRow("delta warm", count, wallTime() - start, pushed, expected, ranks, N);
+
+    freeConvergence(&conv);
+    freeCSRGraph(csr);
+    free(yesterday);
+    free(ranks);
+    free(expected);
+}
+
+static const int batchSizes[] = {1, 2, 4, 8, 16, 32, 64};
+
+// queries per second of PersonalizedPageRank for every batch size, scalar and vector kernels
+void benchmarkPersonalized(const char* name, CSRGraph* csr, int iterations) {
+    int N = csr->numVertices;
+    int sizes = sizeof(batchSizes) / sizeof(batchSizes[0]);
+    int level = simdLevel() < SIMD_LEVEL ? simdLevel() : SIMD_LEVEL;
+    float* expected = (float*)malloc(N * sizeof(float));
+    float* reference = (float*)malloc((long)PPR_QUERIES * N * sizeof(float));
+    float* ranks = (float*)malloc((long)N * batchSizes[sizes-1] * sizeof(float));
+    float* column = (float*)malloc(N * sizeof(float));
+    int* seedOffsets = (int*)malloc((PPR_QUERIES + 1) * sizeof(int));
+    int* seeds = (int*)malloc((PPR_QUERIES * PPR_SEEDS > N ? PPR_QUERIES * PPR_SEEDS : N) * sizeof(int));
+    if (!expected || !reference || !ranks || !column || !seedOffsets || !seeds) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    Tolerance tol;
+    initTolerance(&tol);
+    tol.maxRel = SIMD_TOLERANCE;
+    VerifyResult result;
+
+    // every vertex as the seeds is the global PageRank
+    int all[2] = {0, N};
+    for (int i = 0; i < N; i++) seeds[i] = i;
+    PersonalizedPageRank(csr, level, 1, all, seeds, iterations, ranks, NULL);
+    GoodPageRankContrib(csr, iterations, expected, NULL);
+    verifyRanks(expected, ranks, N, &tol, &result);
+    printf("\n%s, %u vertices, %ld edges, %d queries of %d seeds, %d iterations\n", name, csr->numVertices,
+           csr->numEdges, PPR_QUERIES, PPR_SEEDS, iterations);
+    printf("all vertices as seeds against contrib: \e[1m%s\e[m, max rel %.2e\n",
+           result.pass ? "equal" : "different", result.maxRel);
+
+    // spread over the ids by a multiplicative hash, the same seeds for any batch size
+    for (int q = 0; q <= PPR_QUERIES; q++) seedOffsets[q] = q * PPR_SEEDS;
+    for (int s = 0; s < PPR_QUERIES * PPR_SEEDS; s++) seeds[s] = (int)((s + 1) * 2654435761UL % N);
+
+    printf("%5s %14s %14s %9s  %s\n", "K", "scalar q/s", simdLevelName(level), "x K=1", "ranks");
+    double base = 0.0;
+    for (int b = 0; b < sizes; b++) {
+        int K = batchSizes[b];
+        double qps[2];
+        int pass = 1;
+        double maxRel = 0.0;
+        for (int v = 0; v < 2; v++) {
+            double seconds = 0.0;
+            for (int first = 0; first < PPR_QUERIES; first += K) {
+                int k = PPR_QUERIES - first < K ? PPR_QUERIES - first : K;
+                int offsets[k + 1];
+                for (int q = 0; q <= k; q++) offsets[q] = seedOffsets[first + q] - seedOffsets[first];
+                double start = wallTime();
+                PersonalizedPageRank(csr, v ? level : SIMD_SCALAR, k, offsets, seeds + seedOffsets[first],
+                                     iterations, ranks, NULL);
+                seconds += wallTime() - start;
+                // the single scalar queries are the reference for every batch
+                for (int q = 0; q < k; q++) {
+                    float* ref = reference + (long)(first + q) * N;
+                    for (int i = 0; i < N; i++) column[i] = ranks[(long)i * k + q];
+                    if (K == 1 && v == 0) {
+                        memcpy(ref, column, N * sizeof(float));
+                        continue;
+                    }
+                    verifyRanks(ref, column, N, &tol, &result);
+                    pass &= result.pass;
+                    if (result.maxRel > maxRel) maxRel = result.maxRel;
+                }
+            }
+            qps[v] = PPR_QUERIES / seconds;
+        }
+        if (K == 1) base = qps[0];
+        printf("%5d %14.2lf %14.2lf %9.2lf  \e[1m%s\e[m, max rel %.2e\n", K, qps[0], qps[1], qps[1] / base,
+               pass ? "equal" : "different", maxRel);
+    }
+
+    free(seeds);
+    free(seedOffsets);
+    free(column);
+    free(ranks);
+    free(reference);
+    free(expected);
+}
+
+// reorder cost, contrib engines on the relabeled graph against csr, ranks mapped back and checked
+void benchmarkReorder(const char* name, CSRGraph* csr, int iterations) {
+    int N = csr->numVertices;
+    float* expected = (float*)malloc(N * sizeof(float));
+    float* ranks = (float*)malloc(N * sizeof(float));
+    float* mapped = (float*)malloc(N * sizeof(float));
+    Bench bench;
+    initBench(&bench, "reorder", BENCH_WARMUPS, BENCH_REPS);
+    bench.quiet = 1;
+    VariantRun v = {NULL, csr, iterations, ranks, VARIANT_CONTRIB};
+    double serial = benchRun(&bench, "contrib", runVariant, &v, 0, NULL)->median;
+    v.variant = VARIANT_PARALLEL_CONTRIB;
+    double parallel = benchRun(&bench, "parallel-contrib", runVariant, &v, 0, NULL)->median;
+    GoodPageRankContrib(csr, iterations, expected, NULL);
+
+    Tolerance tol;
+    initTolerance(&tol);
+    tol.maxRel = SIMD_TOLERANCE;
+    VerifyResult result;
+
+    printf("\n%s, %u vertices, %ld edges, %d iterations, contrib %lf s, parallel-contrib %lf s\n", name,
+           csr->numVertices, csr->numEdges, iterations, serial, parallel);
+    printf("%-11s %10s %10s %8s %11s %8s %11s  %s\n", "order", "reorder s", "contrib s", "speedup",
+           "parallel s", "speedup", "break-even", "ranks");
+    for (int method = 0; method < ORDER_METHODS; method++) {
+        double start = wallTime();
+        int* newId = vertexOrder(csr, method);
+        CSRGraph* permuted = permuteCSRGraph(csr, newId);
+        double cost = wallTime() - start;
+
+        v.csr = permuted;
+        v.variant = VARIANT_CONTRIB;
+        double s = benchRun(&bench, orderName(method), runVariant, &v, 0, NULL)->median;
+        v.variant = VARIANT_PARALLEL_CONTRIB;
+        double p = benchRun(&bench, orderName(method), runVariant, &v, 0, NULL)->median;
+
+        GoodPageRankContrib(permuted, iterations, ranks, NULL);
+        unpermuteRanks(ranks, newId, N, mapped);
+        verifyRanks(expected, mapped, N, &tol, &result);
+        printf("%-11s %10.4lf %10.4lf %7.2lfx %11.4lf %7.2lfx", orderName(method), cost, s, serial / s, p,
+               parallel / p);
+        // iterations of the serial engine the relabeling pays for itself after
+        if (s < serial) printf(" %11.0lf", cost / ((serial - s) / iterations));
+        else printf(" %11s", "never");
+        printf("  \e[1m%s\e[m, max rel %.2e\n", result.pass ? "equal" : "different", result.maxRel);
+
+        freeCSRGraph(permuted);
+        free(newId);
+    }
+
+    free(expected);
+    free(ranks);
+    free(mapped);
+    freeBench(&bench);
+}
+
+// one run of the pull engine or a blocked one for benchmarkBlocking
+typedef struct BlockRun {
+    CSRGraph* csr;
+    TiledGraph* tiled;   // runs when not NULL
+    BinnedGraph* binned; // runs when not NULL and tiled is, csr runs when both are
+    int iterations;
+    float* ranks;
+} BlockRun;
+
+void runBlocked(void* ctx) {
+    BlockRun* r = (BlockRun*)ctx;
+    if (r->tiled) GoodPageRankTiled(r->tiled, r->iterations, r->ranks, NULL);
+    else if (r->binned) GoodPageRankBinned(r->binned, r->iterations, r->ranks, NULL);
+    else GoodPageRankContrib(r->csr, r->iterations, r->ranks, NULL);
+}
+
+static const int blockingSizes[] = {1 << 17, 1 << 19, 1 << 21, 1 << 22};
+static const int blockingBits[] = {16, BLOCK_BITS, 20};
+#define BLOCKING_LAYOUTS 3
+
+// ns per edge of the pull engine against tiles and bins of 2^bits vertices on
+// growing random graphs, the crossover is the first size a blocked layout wins
+void benchmarkBlocking(void) {
+    int sizes = sizeof(blockingSizes) / sizeof(blockingSizes[0]);
+    int crossTiled = 0, crossBinned = 0;
+    Tolerance tol;
+    initTolerance(&tol);
+    tol.maxRel = SIMD_TOLERANCE;
+    VerifyResult result;
+
+    printf("%8s %9s %7s", "vertices", "edges", "pull");
+    for (int b = 0; b < BLOCKING_LAYOUTS; b++) printf("  tiled-%-2d", blockingBits[b]);
+    for (int b = 0; b < BLOCKING_LAYOUTS; b++) printf("  binned-%-2d", blockingBits[b]);
+    printf("   ns per edge\n");
+
+    for (int s = 0; s < sizes; s++) {
+        int N = blockingSizes[s];
+        EdgeList* edges = generateErdosRenyi(N, (long)N * BLOCKING_DEGREE, SEED, 0);
+        CSRGraph* csr = edgeListToCSR(edges);
+        freeEdgeList(edges);
+        double work = (double)csr->numEdges * BLOCKING_ITERATIONS;
+        float* expected = (float*)malloc(N * sizeof(float));
+
+        Bench bench;
+        initBench(&bench, "blocking", BENCH_WARMUPS, BLOCKING_REPS);
+        bench.quiet = 1;
+        BlockRun run = {csr, NULL, NULL, BLOCKING_ITERATIONS, expected};
+        double pull = benchRun(&bench, "pull", runBlocked, &run, work, "edges")->median;
+        printf("%8d %9ld %7.2lf", N, csr->numEdges, pull * 1e9 / work);
+
+        run.ranks = (float*)malloc(N * sizeof(float));
+        double best[2] = {pull, pull};
+        int verified = 1;
+        for (int layout = 0; layout < 2; layout++) {
+            for (int b = 0; b < BLOCKING_LAYOUTS; b++) {
+                if (layout == 0) run.tiled = createTiledGraph(NULL, csr, blockingBits[b]);
+                else run.binned = createBinnedGraph(NULL, csr, blockingBits[b]);
+                double t = benchRun(&bench, layout ? "binned" : "tiled", runBlocked, &run, work, "edges")->median;
+                printf("  %*.2lf", layout ? 9 : 8, t * 1e9 / work);
+                if (t < best[layout]) best[layout] = t;
+                verified &= verifyRanks(expected, run.ranks, N, &tol, &result);
+                freeTiledGraph(run.tiled);
+                freeBinnedGraph(run.binned);
+                run.tiled = NULL;
+                run.binned = NULL;
+            }
+        }
+        printf("   ranks %s\n", verified ? "equal" : "\e[1mdifferent\e[m");
+        if (!crossTiled && best[0] < pull) crossTiled = N;
+        if (!crossBinned && best[1] < pull) crossBinned = N;
+
+        free(run.ranks);
+        free(expected);
+        freeBench(&bench);
+        freeCSRGraph(csr);
+    }
+
+    const char* layouts[2] = {"tiled", "binned"};
+    int cross[2] = {crossTiled, crossBinned};
+    for (int layout = 0; layout < 2; layout++) {
+        if (cross[layout] == blockingSizes[0]) printf("%s beats pull at every size tried\n", layouts[layout]);
+        else if (cross[layout]) printf("%s beats pull from %d vertices\n", layouts[layout], cross[layout]);
+        else printf("%s doesn't beat pull up to %d vertices\n", layouts[layout], blockingSizes[sizes - 1]);
+    }
+}
+
+static const char* phaseNames[PHASES] = {"update", "dangling", "contrib", "swap"};
+
+// hardware counters per phase of each parallel kernel on csr
+void profilePhases(CSRGraph* csr, int iterations) {
+    static const char* kernelNames[] = {"divide", "contrib", "simd"};
+    float* ranks = (float*)malloc(csr->numVertices * sizeof(float));
+    for (int kernel = KERNEL_DIVIDE; kernel <= KERNEL_SIMD; kernel++) {
+        if (perfBegin(phaseNames, PHASES) != 0) break;
+        double start = wallTime();
+        runParallelPageRank(NULL, csr, kernel, iterations, ranks, NULL);
+        printf("\nparallel-%s, %d threads, %u vertices, %ld edges, %d iterations in %lf s\n",
+               kernelNames[kernel], threadCount, csr->numVertices, csr->numEdges, iterations, wallTime() - start);
+        perfReport((double)csr->numEdges * iterations);
+        perfEnd();
+    }
+    free(ranks);
+}
+
+// ./main [graph.txt | graph.mtx [out.graph]], a random graph when no file is given,
+// out.graph gets the loaded graph in the binary format for mapCSRGraphFile,
+// ./main --sweep [max threads] runs the scaling sweep instead,
+// ./main --perf [graph file] counts the phases of the parallel kernels,
+// ./main --reorder [graph file] times the relabelings and PageRank on them,
+// ./main --blocking measures where the tiled and binned engines overtake pull,
+// ./main --edge-cost times one edge of the divide, contrib and vector kernels,
+// ./main --graph-file times writing and mapping GRAPH_FILE_BENCH in the working directory,
+// ./main --pools [graph file] times the mutex queue against work stealing on empty and skewed blocks,
+// ./main --barriers [max threads] times the barriers up to threadCount + 1, main2.c's workers and main,
+// ./main --generators times the random graph generators on 1 thread and on threadCount,
+// ./main --gauss-seidel times the in-place engines to TOLERANCE against the Jacobi ones,
+// ./main --delta [graph file] counts the edges the push engine needs against pull,
+// ./main --personalized [graph file] measures personalized queries per second by batch size,
+// ./main --dynamic [graph file] times incremental updates under edge batches against full runs,
+// ./main --checkpoint [graph file] resumes a cut off run and warm starts the next day's graph
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--checkpoint") == 0) {
+        EdgeList* edges;
+        if (argc > 2) {
+            edges = loadEdgeList(argv[2], graphFormat(argv[2]), 0, NULL);
+            if (edges == NULL) return 1;
+        } else {
+            edges = generateErdosRenyi(CHECKPOINT_N, (long)CHECKPOINT_N * CHECKPOINT_DEGREE, SEED, 0);
+        }
+        benchmarkCheckpoint(argc > 2 ? argv[2] : "erdos-renyi", edges, CHECKPOINT_ITERATIONS);
+        freeEdgeList(edges);
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "--dynamic") == 0) {
+        Graph* graph;
+        if (argc > 2) {
+            graph = loadGraph(argv[2], 0, NULL);
+            if (graph == NULL) return 1;
+        } else {
+            EdgeList* edges = generateErdosRenyi(DYNAMIC_N, (long)DYNAMIC_N * DYNAMIC_DEGREE, SEED, 0);
+            graph = edgeListToGraph(edges);
+            freeEdgeList(edges);
+        }
+        benchmarkDynamic(argc > 2 ? argv[2] : "erdos-renyi", graph, DYNAMIC_ITERATIONS);
+        freeGraph(graph);
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "--personalized") == 0) {
+        CSRGraph* csr;
+        if (argc > 2) {
+            csr = loadCSRGraph(argv[2], 0, NULL);
+            if (csr == NULL) return 1;
+        } else {
+            EdgeList* edges = generateRMAT(PPR_N, (long)PPR_N * PPR_DEGREE, RMAT_A, RMAT_B, RMAT_C, SEED, 0);
+            csr = edgeListToCSR(edges);
+            freeEdgeList(edges);
+        }
+        benchmarkPersonalized(argc > 2 ? argv[2] : "rmat", csr, PPR_ITERATIONS);
+        freeCSRGraph(csr);
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "--blocking") == 0) {
+        benchmarkBlocking();
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "--edge-cost") == 0) {
+        benchmarkEdgeCost(EDGE_COST_N, EDGE_COST_EDGES, EDGE_COST_ITERATIONS);
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "--graph-file") == 0) {
+        benchmarkGraphFile(GRAPH_FILE_N, GRAPH_FILE_EDGES, GRAPH_FILE_ITERATIONS);
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "--pools") == 0) {
+        CSRGraph* csr;
+        if (argc > 2) {
+            csr = loadCSRGraph(argv[2], 0, NULL);
+            if (csr == NULL) return 1;
+        } else {
+            EdgeList* edges = generateErdosRenyi(POOL_N, (long)POOL_N * POOL_DEGREE, SEED, 0);
+            csr = edgeListToCSR(edges);
+            freeEdgeList(edges);
+        }
+        benchmarkPools(csr, POOL_TASKS, POOL_ROUNDS);
+        freeCSRGraph(csr);
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "--barriers") == 0) {
+        benchmarkBarriers(argc > 2 ? atoi(argv[2]) : threadCount + 1, BARRIER_ROUNDS);
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "--generators") == 0) {
+        benchmarkGenerators(GENERATORS_N, GENERATORS_EDGES);
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "--gauss-seidel") == 0) {
+        benchmarkGaussSeidel(GAUSS_SEIDEL_N, GAUSS_SEIDEL_EDGES, GAUSS_SEIDEL_ITERATIONS);
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "--sweep") == 0) {
+        sweep(argc > 2 ? atoi(argv[2]) : SWEEP_MAX_THREADS);
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "--perf") == 0) {
+        CSRGraph* csr;
+        if (argc > 2) {
+            csr = loadCSRGraph(argv[2], 0, NULL);
+            if (csr == NULL) return 1;
+        } else {
+            EdgeList* edges = generateErdosRenyi(PERF_N, (long)PERF_N * PERF_DEGREE, SEED, 0);
+            csr = edgeListToCSR(edges);
+            freeEdgeList(edges);
+        }
+        profilePhases(csr, PERF_ITERATIONS);
+        freeCSRGraph(csr);
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "--delta") == 0) {
+        if (argc > 2) {
+            EdgeList* edges = loadEdgeList(argv[2], graphFormat(argv[2]), 0, NULL);
+            if (edges == NULL) return 1;
+            benchmarkDelta(argv[2], edges, DELTA_ITERATIONS);
+            freeEdgeList(edges);
+            return 0;
+        }
+        EdgeList* edges = generateErdosRenyi(DELTA_N, (long)DELTA_N * DELTA_DEGREE, SEED, 0);
+        benchmarkDelta("erdos-renyi", edges, DELTA_ITERATIONS);
+        freeEdgeList(edges);
+        edges = generateRMAT(DELTA_N, (long)DELTA_N * DELTA_DEGREE, RMAT_A, RMAT_B, RMAT_C, SEED, 0);
+        benchmarkDelta("rmat", edges, DELTA_ITERATIONS);
+        freeEdgeList(edges);
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "--reorder") == 0) {
+        if (argc > 2) {
+            CSRGraph* csr = loadCSRGraph(argv[2], 0, NULL);
+            if (csr == NULL) return 1;
+            benchmarkReorder(argv[2], csr, REORDER_ITERATIONS);
+            freeCSRGraph(csr);
+            return 0;
+        }
+        // uniform degrees, then the skewed ones reordering is meant for
+        EdgeList* edges = generateErdosRenyi(REORDER_N, (long)REORDER_N * REORDER_DEGREE, SEED, 0);
+        CSRGraph* csr = edgeListToCSR(edges);
+        freeEdgeList(edges);
+        benchmarkReorder("erdos-renyi", csr, REORDER_ITERATIONS);
+        freeCSRGraph(csr);
+        edges = generateRMAT(REORDER_N, (long)REORDER_N * REORDER_DEGREE, RMAT_A, RMAT_B, RMAT_C, SEED, 0);
+        csr = edgeListToCSR(edges);
+        freeEdgeList(edges);
+        benchmarkReorder("rmat", csr, REORDER_ITERATIONS);
+        freeCSRGraph(csr);
+        return 0;
+    }
+
+    int N = 1000; // number of nodes
+    int iterations = 100; // number of iterations
+
+    double start, end;
+
+    // Initialize the graph, nodes come from slabs instead of one malloc each
+    start = wallTime();
+    Graph *graph;
+    if (argc > 1) {
+        LoadStats load;
+        graph = loadGraph(argv[1], 0, &load);
+        if (graph == NULL) return 1;
+        printLoadStats(argv[1], &load);
+        if (argc > 2 && writeGraphFile(argv[2], graph) != 0) return 1;
+        N = graph->numVertices;
+    } else {
+        graph = createArenaGraph(N);
+        generateRandomGraph(graph, N, 10000);
+    }
+    end   = wallTime();
+
+    GraphAllocStats stats;
+    getGraphAllocStats(graph, &stats);
+    printf("time to build: %lf (%ld nodes, %ld slabs, %zu of %zu bytes used)\n",
+           end-start, stats.nodes, stats.slabs, stats.bytesUsed, stats.bytesReserved);
+    
+    float *ranks = (float *)malloc(N * sizeof(float));
+    CSRGraph *csr = createCSRGraph(graph);
+
+    benchmarkVariants(graph, csr, iterations);
+
+    // same kernels, stopping once the ranks settle
+    Convergence conv;
+    initConvergence(&conv, TOLERANCE, NORM_L1, iterations);
+
+    GoodPageRankConverge(graph, iterations, ranks, &conv);
+    printConvergence(&conv, "good", 1);
+
+    runParallelPageRank(NULL, csr, KERNEL_CONTRIB, iterations, ranks, &conv);
+    printConvergence(&conv, "parallel", 0);
+    long pulled = csr->numEdges * conv.iterations;
+
+    GaussSeidelPageRank(csr, iterations, ranks, &conv);
+    printConvergence(&conv, "gauss-seidel", 0);
+
+    AsyncPageRank(csr, iterations, ranks, &conv);
+    printConvergence(&conv, "async", 0);
+
+    long pushed = DeltaPageRank(csr, iterations, ranks, &conv);
+    printConvergence(&conv, "delta", 0);
+    printf("delta processed %ld edges, parallel %ld\n", pushed, pulled);
+
+    freeConvergence(&conv);
+
+    // vector sums are reordered, so they only match up to rounding
+    float *simdRanks = (float *)malloc(N * sizeof(float));
+    Tolerance tol;
+    initTolerance(&tol);
+    tol.maxRel = SIMD_TOLERANCE;
+    VerifyResult result;
+    GoodPageRank(graph, iterations, ranks);
+    for (int level = SIMD_SCALAR; level <= simdLevel(); level++) {
+        GoodPageRankSIMD(csr, level, iterations, simdRanks, NULL);
+        verifyRanks(ranks, simdRanks, N, &tol, &result);
+        printVerify("good", simdLevelName(level), &result);
+    }
+    free(simdRanks);
+
+    stressParallel(graph, csr, iterations, 50);
+
+    freeCSRGraph(csr);
+
+    // Free allocated memory
     free(ranks);
-    free(graph->adjacencyListsOut);
-    free(graph);
+    freeGraph(graph);
 
     return 0;
 }
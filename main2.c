@@ -1,25 +1,52 @@
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include "graph.h"
+#include "convergence.h"
+#include "barrier.h"
+#include "bench.h"
 #include <time.h>
 
 #define D 0.15 // damping factor
-#define T 8    // thread count
+#define T 8    // default thread count
 #define CACHE_LINE_SIZE_FP 16
 #define BLOCK_SIZE (10 * CACHE_LINE_SIZE_FP) // cache line count
+#define KERNEL_DIVIDE  0 // ranks[u] / outLength[u] for every edge
+#define KERNEL_CONTRIB 1 // contrib[u] = ranks[u] * invOutDeg[u] once per vertex
+#define BALANCE 1        // split vertices by in-edges, 0 gives each thread N/T vertices
+#define REPORT_BALANCE 0 // print edges and barrier wait per thread
 
 // #define _POSIX_BARRIERS 1
-pthread_barrier_t barrier; // Barrier for synchronization
+SpinBarrier barrier; // Barrier for synchronization, spins then parks
+int threadCount = T; // workers of the next runParallelPageRank
 
-typedef struct ThreadData {
+// one cache line apart, each thread writes its own stats every iteration
+typedef struct __attribute__((aligned(64))) ThreadData {
+    struct ThreadPool* pool;
     Graph* graph;
+    CSRGraph* csr; // used instead of graph when not NULL
     float* ranks;
     float* newRanks;
+    float* contrib; // KERNEL_CONTRIB, NULL divides per edge
     int start;
     int end;
     double sumB;
     int N;
+    // this thread's residual, reduced by the main thread
+    double l1;
+    double linf;
+    // inputs of the next iteration, produced while this thread's ranks are hot
+    float* nextContrib; // NULL when contrib is
+    float* invOutDeg;
+    int* dangling;      // sorted ids without outlinks
+    int danglingStart;  // slice of dangling inside start..end-1
+    int danglingEnd;
+    double danglingSum;
+    long edges;      // in-edges of start..end-1
+    double busyTime; // seconds computing
+    double waitTime; // seconds at the second barrier after computing
 } ThreadData;
 
 typedef struct ThreadPool {
@@ -27,140 +54,264 @@ typedef struct ThreadPool {
     pthread_t* threads;
     ThreadData* thread_data;
     int iterations;
+    int stop; // set by the main thread before the first barrier
 } ThreadPool;
 
 // Function to compute partial ranks for a segment
 void computePartialRanks(ThreadData* data) {
+    // accumulate in registers, data is only written once at the end of the block
+    double l1 = 0.0, linf = 0.0;
+
     for (int i = data->start; i < data->end; i++) {
         double sumA = 0.0;
-        node* u = data->graph->adjacencyListsIn[i];
-        while (u != NULL) {
-            sumA += data->ranks[u->v] / data->graph->adjacencyListsOutLength[u->v];
-            u = u->next;
+        if (data->csr != NULL && data->contrib != NULL) {
+            CSRGraph* csr = data->csr;
+            for (long k = csr->inOffsets[i]; k < csr->inOffsets[i + 1]; k++) {
+                sumA += data->contrib[csr->inNeighbors[k]];
+            }
+        } else if (data->csr != NULL) {
+            CSRGraph* csr = data->csr;
+            for (long k = csr->inOffsets[i]; k < csr->inOffsets[i + 1]; k++) {
+                vertex u = csr->inNeighbors[k];
+                sumA += data->ranks[u] / csr->outDegree[u];
+            }
+        } else if (data->contrib != NULL) {
+            for (node* u = data->graph->adjacencyListsIn[i]; u != NULL; u = u->next) {
+                sumA += data->contrib[u->v];
+            }
+        } else {
+            node* u = data->graph->adjacencyListsIn[i];
+            while (u != NULL) {
+                sumA += data->ranks[u->v] / data->graph->adjacencyListsOutLength[u->v];
+                u = u->next;
+            }
         }
-        data->newRanks[i] = D / data->N + (1 - D) * (sumA + data->sumB);
+        float rank = D / data->N + (1 - D) * (sumA + data->sumB);
+        double diff = fabs(rank - data->ranks[i]);
+        l1 += diff;
+        if (diff > linf) linf = diff;
+        data->newRanks[i] = rank;
     }
-}
 
-// Worker thread function
-void* worker_thread(void* arg) {
-    ThreadPool* pool = (ThreadPool*)arg;
-    // Determine thread index
-    pthread_t self = pthread_self();
-    int thread_idx = -1;
-    for (int i = 0; i < pool->thread_count; i++) {
-        if (pthread_equal(self, pool->threads[i])) {
-            thread_idx = i;
-            break;
-        }
+    data->l1 = l1;
+    data->linf = linf;
+
+    // dangling mass and contributions of the ranks just written
+    double dangling = 0.0;
+    for (int k = data->danglingStart; k < data->danglingEnd; k++) {
+        dangling += data->newRanks[data->dangling[k]];
     }
-    if (thread_idx == -1) {
-        fprintf(stderr, "Thread not found in pool\n");
-        pthread_exit(NULL);
+    data->danglingSum = dangling;
+    if (data->nextContrib != NULL) {
+        for (int i = data->start; i < data->end; i++) {
+            data->nextContrib[i] = data->newRanks[i] * data->invOutDeg[i];
+        }
     }
+}
 
-    ThreadData* data = &pool->thread_data[thread_idx];
+// Worker thread function, arg is the thread's own ThreadData
+void* worker_thread(void* arg) {
+    ThreadData* data = (ThreadData*)arg;
+    ThreadPool* pool = data->pool;
+    int sense = 0;
 
-    for (int iter = 0; iter < pool->iterations; iter++) {
+    while (1) {
         // Wait for main thread to set sumB
-        pthread_barrier_wait(&barrier);
+        spinBarrierWait(&barrier, &sense);
+        if (pool->stop) break;
 
         // Compute partial ranks
+        double start = wallTime();
         computePartialRanks(data);
+        double done = wallTime();
 
         // Wait for all threads to finish computation
-        pthread_barrier_wait(&barrier);
+        spinBarrierWait(&barrier, &sense);
+        data->busyTime += done - start;
+        data->waitTime += wallTime() - done;
     }
     return NULL;
 }
 
-void ParallelPageRank(Graph *graph, int iterations, float* ranks) {
-    int N = graph->numVertices;
+// runs on csr when given, on the linked lists of graph otherwise,
+// conv may be NULL to run a fixed number of iterations
+void runParallelPageRank(Graph *graph, CSRGraph *csr, int kernel, int iterations, float* ranks, Convergence* conv) {
+    int N = csr ? (int)csr->numVertices : (int)graph->numVertices;
+    int threads = threadCount;
+    int* outLength = csr ? csr->outDegree : graph->adjacencyListsOutLength;
     float *newRanks = (float *)malloc(N * sizeof(float));
     if (!newRanks) {
         perror("Failed to allocate newRanks");
         exit(EXIT_FAILURE);
     }
 
-    // Initialize the barrier with T worker threads + 1 main thread
-    if (pthread_barrier_init(&barrier, NULL, T + 1)) {
-        fprintf(stderr, "Could not create a barrier\n");
-        exit(EXIT_FAILURE);
+    // 1/outDegree once, so the edge loop never divides
+    // double buffered, threads write the next one while others still read this one
+    float *contrib = NULL, *nextContrib = NULL, *invOutDeg = NULL;
+    if (kernel == KERNEL_CONTRIB) {
+        contrib = (float *)malloc(N * sizeof(float));
+        nextContrib = (float *)malloc(N * sizeof(float));
+        invOutDeg = (float *)malloc(N * sizeof(float));
+        if (!contrib || !nextContrib || !invOutDeg) {
+            perror("Failed to allocate contrib");
+            exit(EXIT_FAILURE);
+        }
+        for (int i = 0; i < N; i++) {
+            invOutDeg[i] = (outLength[i] == 0) ? 0.0f : 1.0f / outLength[i];
+        }
+    }
+    int danglingCount;
+    int* dangling = danglingList(outLength, N, &danglingCount);
+
+    float* out = ranks;
+    initializeRanks(ranks, N); // Initialize ranks
+
+    // Only the first iteration's inputs are computed here, the threads produce the rest
+    double sumB = 0.0;
+    for (int k = 0; k < danglingCount; k++) {
+        sumB += ranks[dangling[k]];
+    }
+    sumB /= N;
+    if (contrib != NULL) {
+        for (int i = 0; i < N; i++) {
+            contrib[i] = ranks[i] * invOutDeg[i];
+        }
     }
 
+    // Initialize the barrier with one party per worker + 1 main thread
+    initSpinBarrier(&barrier, threads + 1);
+    int sense = 0;
+
     // Initialize thread pool
     ThreadPool pool;
-    pool.thread_count = T;
+    pool.thread_count = threads;
     pool.iterations = iterations;
-    pool.threads = malloc(T * sizeof(pthread_t));
-    pool.thread_data = malloc(T * sizeof(ThreadData));
+    pool.stop = 0;
+    pool.threads = malloc(threads * sizeof(pthread_t));
+    pool.thread_data = aligned_alloc(64, threads * sizeof(ThreadData));
     if (!pool.threads || !pool.thread_data) {
         perror("Failed to allocate threads or thread_data");
         exit(EXIT_FAILURE);
     }
 
     // Determine the workload for each thread
-    int chunk_size = (N + T - 1) / T; // Ceiling division
+    int bounds[threads + 1];
+    if (BALANCE) {
+        // about the same number of edges each, hubs don't pile up on one thread
+        partitionByInEdges(graph, csr, threads, bounds);
+    } else {
+        int chunk_size = (N + threads - 1) / threads; // Ceiling division
+        for (int i = 0; i <= threads; i++) {
+            bounds[i] = (i * chunk_size > N) ? N : i * chunk_size;
+        }
+    }
 
-    for (int i = 0; i < T; i++) {
+    for (int i = 0; i < threads; i++) {
         pool.thread_data[i].graph = graph;
+        pool.thread_data[i].csr = csr;
         pool.thread_data[i].ranks = ranks;
         pool.thread_data[i].newRanks = newRanks;
-        pool.thread_data[i].sumB = 0.0; // Will be computed each iteration
+        pool.thread_data[i].contrib = contrib;
+        pool.thread_data[i].nextContrib = nextContrib;
+        pool.thread_data[i].invOutDeg = invOutDeg;
+        pool.thread_data[i].sumB = sumB; // Reduced from the threads after each iteration
         pool.thread_data[i].N = N;
-        pool.thread_data[i].start = i * chunk_size;
-        pool.thread_data[i].end = (i + 1) * chunk_size;
-        if (pool.thread_data[i].end > N) pool.thread_data[i].end = N;
+        pool.thread_data[i].start = bounds[i];
+        pool.thread_data[i].end = bounds[i + 1];
+        pool.thread_data[i].dangling = dangling;
+        pool.thread_data[i].danglingStart = danglingLowerBound(dangling, danglingCount, bounds[i]);
+        pool.thread_data[i].danglingEnd = danglingLowerBound(dangling, danglingCount, bounds[i + 1]);
+        pool.thread_data[i].edges = 0;
+        for (int v = bounds[i]; v < bounds[i + 1]; v++) {
+            pool.thread_data[i].edges += csr ? csr->inOffsets[v + 1] - csr->inOffsets[v]
+                                             : graph->adjacencyListsInLength[v];
+        }
+        pool.thread_data[i].busyTime = 0.0;
+        pool.thread_data[i].waitTime = 0.0;
+
+        pool.thread_data[i].pool = &pool;
 
-        if (pthread_create(&pool.threads[i], NULL, worker_thread, (void*)&pool)) {
+        // pass the data itself, pool.threads[i] may not be set yet when the thread starts
+        if (pthread_create(&pool.threads[i], NULL, worker_thread, (void*)&pool.thread_data[i])) {
             perror("Failed to create thread");
             exit(EXIT_FAILURE);
         }
     }
 
-    initializeRanks(ranks, N); // Initialize ranks
-
     for (int iter = 0; iter < iterations; iter++) {
-        double sumB = 0.0;
+        // First barrier: main thread waits for all worker threads to reach this point
+        spinBarrierWait(&barrier, &sense);
 
-        // Calculate the sum of ranks of nodes without outlinks
-        for (int i = 0; i < N; i++) {
-            if (graph->adjacencyListsOutLength[i] == 0) {
-                sumB += ranks[i];
-            }
-        }
-        sumB /= N;
+        // Second barrier: wait for worker threads to finish computation
+        spinBarrierWait(&barrier, &sense);
 
-        // Assign sumB to each thread's data
-        for (int i = 0; i < T; i++) {
-            pool.thread_data[i].sumB = sumB;
+        // Reduce the per-thread residuals and dangling mass
+        double l1 = 0.0, linf = 0.0;
+        sumB = 0.0;
+        for (int i = 0; i < threads; i++) {
+            l1 += pool.thread_data[i].l1;
+            if (pool.thread_data[i].linf > linf) linf = pool.thread_data[i].linf;
+            sumB += pool.thread_data[i].danglingSum;
         }
+        sumB /= N;
 
-        // First barrier: main thread waits for all worker threads to reach this point
-        pthread_barrier_wait(&barrier);
-
-        // Swap ranks
+        // Swap ranks and contributions, only once workers are done reading them
         float* temp = ranks;
         ranks = newRanks;
         newRanks = temp;
+        temp = contrib;
+        contrib = nextContrib;
+        nextContrib = temp;
 
-        // Update ranks pointer in thread data for next iteration
-        for (int i = 0; i < T; i++) {
+        // Update pointers and sumB in thread data for next iteration
+        for (int i = 0; i < threads; i++) {
             pool.thread_data[i].ranks = ranks;
             pool.thread_data[i].newRanks = newRanks;
+            pool.thread_data[i].contrib = contrib;
+            pool.thread_data[i].nextContrib = nextContrib;
+            pool.thread_data[i].sumB = sumB;
         }
 
-        // Second barrier: wait for worker threads to finish computation
-        pthread_barrier_wait(&barrier);
+        if (recordResidual(conv, iter, l1, linf)) break;
     }
 
+    // Release the workers waiting at the first barrier
+    pool.stop = 1;
+    spinBarrierWait(&barrier, &sense);
+
     // Join threads
-    for (int i = 0; i < T; i++) {
+    for (int i = 0; i < threads; i++) {
         pthread_join(pool.threads[i], NULL);
     }
 
-    pthread_barrier_destroy(&barrier);
+    if (REPORT_BALANCE) {
+        printf("thread  vertices       edges    busy (s)    wait (s)\n");
+        for (int i = 0; i < threads; i++) {
+            ThreadData* d = &pool.thread_data[i];
+            printf("%6d  %8d  %10ld  %10.6f  %10.6f\n", i, d->end - d->start, d->edges, d->busyTime, d->waitTime);
+        }
+    }
+
+    // An odd number of swaps leaves the result in our buffer
+    if (ranks != out) {
+        memcpy(out, ranks, N * sizeof(float));
+        newRanks = ranks;
+    }
+
+    destroySpinBarrier(&barrier);
     free(pool.threads);
     free(pool.thread_data);
+    free(dangling);
+    free(contrib);
+    free(nextContrib);
+    free(invOutDeg);
     free(newRanks);
 }
+
+void ParallelPageRank(Graph *graph, int iterations, float* ranks) {
+    runParallelPageRank(graph, NULL, KERNEL_DIVIDE, iterations, ranks, NULL);
+}
+
+void ParallelPageRankCSR(CSRGraph *csr, int iterations, float* ranks) {
+    runParallelPageRank(NULL, csr, KERNEL_DIVIDE, iterations, ranks, NULL);
+}
@@ -1,13 +1,21 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "graph.h"
+#include "generator.h"
+#include "bench.h"
+#include "verify.h"
 #include <time.h>
+#include <string.h>
+#include <math.h>
 
 #define N 10  // node count
 #define M 20  // edge count
+#define SEED 1   // picks the random graph
 #define D 0.15 // damping factor
 #define T 8    // thread count
 #define I 100  // iterations count
+#define TOL 0.0  // stop once an iteration moves the ranks less than this (L1), 0 runs all I
+#define BI 10  // benchmark repetitions, after one warmup
 // should be 16
 #define BLOCK_SIZE (64 / sizeof(float))
 
@@ -41,12 +49,16 @@ void printRanksStruct(e* ranks) {
     printf("\n");
 }
 
+// iterations the last kernel ran, less than I when it converged
+int iterationsRun = I;
+
 void PageRank(Graph *graph, float* ranks) {
 
     float *newRanks = (float *)malloc(N * sizeof(float));
     int* outlinkes = (int*)calloc(N, sizeof(int));
 
     initializeRanks(ranks);
+    iterationsRun = I;
     
     //outlinks calculations
     
@@ -99,11 +111,14 @@ void PageRank(Graph *graph, float* ranks) {
 void GoodPageRank(Graph *graph, float* ranks) {
 
     float *newRanks = (float *)malloc(N * sizeof(float));
+    float *out = ranks;
     initializeRanks(ranks);
 
+    iterationsRun = I;
     for (int iter = 0; iter < I; iter++) {
 
         double sumB = 0.0;
+        double residual = 0.0;
         // calculate the sum of ranks of those without outlinks
         for (int i=0; i < N; i++) {
             // dont divide outside for precision
@@ -121,12 +136,24 @@ void GoodPageRank(Graph *graph, float* ranks) {
                 u = u->next;
             }
             newRanks[i] = D/N +(1-D)*(sumA+sumB);
+            residual += fabs(newRanks[i] - ranks[i]);
         }
 
         // pointer switching instead of slow assignment
         float* temp = newRanks;
         newRanks = ranks;
         ranks = temp;
+
+        if (residual < TOL) {
+            iterationsRun = iter + 1;
+            break;
+        }
+    }
+
+    // an odd number of switches leaves the result in our buffer
+    if (ranks != out) {
+        memcpy(out, ranks, N * sizeof(float));
+        newRanks = ranks;
     }
 
     free(newRanks);
@@ -135,11 +162,14 @@ void GoodPageRank(Graph *graph, float* ranks) {
 void ParallelPageRank(Graph *graph, float *ranks)
 {
     float *newRanks = (float *)malloc(N * sizeof(float));
+    float *out = ranks;
     initializeRanks(ranks);
 
+    iterationsRun = I;
     for (int iter = 0; iter < I; iter++) {
 
         double sumB = 0.0;
+        double residual = 0.0;
         // calculate the sum of ranks of those without outlinks
         for (int i=0; i < N; i++) {
             // dont divide outside for precision
@@ -157,33 +187,56 @@ void ParallelPageRank(Graph *graph, float *ranks)
                 u = u->next;
             }
             newRanks[i] = D/N +(1-D)*(sumA+sumB);
+            residual += fabs(newRanks[i] - ranks[i]);
         }
 
         // pointer switching instead of slow assignment
         float* temp = newRanks;
         newRanks = ranks;
         ranks = temp;
+
+        if (residual < TOL) {
+            iterationsRun = iter + 1;
+            break;
+        }
+    }
+
+    // an odd number of switches leaves the result in our buffer
+    if (ranks != out) {
+        memcpy(out, ranks, N * sizeof(float));
+        newRanks = ranks;
     }
 
     free(newRanks);
 }
 
+Bench ranksBench; // benchmark rows, speedups against the first
+
+typedef struct RankRun {
+    Graph* graph;
+    void (*f)(Graph*, float*);
+    float* ranks;
+} RankRun;
+
+void runRanks(void* ctx) {
+    RankRun* run = (RankRun*)ctx;
+    run->f(run->graph, run->ranks);
+}
+
 void benchmark(Graph* graph, void (*f)(Graph*, float*), char* name) {
     float *ranks = (float *)calloc(N, sizeof(float));
-    double start, end, total = 0;
-
-    start = (double)clock() / CLOCKS_PER_SEC;
+    RankRun run = {graph, f, ranks};
 
+    // the warmup run, and it tells how many iterations the timed ones do
     f(graph, ranks);
+    long edges = 0;
+    for (int i = 0; i < N; i++) edges += graph->adjacencyListsInLength[i];
 
-    end = (double)clock() / CLOCKS_PER_SEC;
-    total += (end - start);
-    // Print the ranks
-    // for (int i = 0; i < N; i++) { printf("Rank of node %d: %f\n", i, ranks[i]); }
-    printf("time to calc %-9s  \e[1m%lf\e[m\n", name, total);   
+    benchRun(&ranksBench, name, runRanks, &run, (double)edges * iterationsRun, "edges");
     free(ranks);
 }
 
+// ranks up to rounding, and the orderings they give
 void compare(Graph* graph, void (*f1)(Graph*, float*), void (*f2)(Graph*, float*), char* name1, char* name2) {
     float *ranks1 = (float *)calloc(N, sizeof(float));
     float *ranks2 = (float *)calloc(N, sizeof(float));
@@ -191,39 +244,34 @@ void compare(Graph* graph, void (*f1)(Graph*, float*), void (*f2)(Graph*, float*
     f1(graph, ranks1);
     f2(graph, ranks2);
 
-    int same = 1;
-    for (int i=0; i < N; i++) {
-        if (ranks1[i] != ranks2[i]) same = 0;
-    }
-    // some terminal sugar
-    printf("%-6s and %-8s are \e[1m%s\e[m\n", name1, name2, (same == 0 ? "different" : "equal"));
+    Tolerance tol;
+    initTolerance(&tol);
+    VerifyResult result;
+    verifyRanks(ranks1, ranks2, N, &tol, &result);
+    printVerify(name1, name2, &result);
     free(ranks1); free(ranks2);
 }
 
+// sums up to rounding, a reordered parallel sum rarely matches bit for bit
 void compare2(Graph* graph, float (*f1)(Graph*), float (*f2)(Graph*), char* name1, char* name2) {
-
     float s1 = f1(graph);
     float s2 = f2(graph);
 
-    int same = (s1 == s2);
-    // some terminal sugar
-    printf("%-6s and %-8s are \e[1m%s\e[m\n", name1, name2, (same == 0 ? "different" : "equal"));
+    Tolerance tol;
+    initTolerance(&tol);
+    VerifyResult result;
+    verifyRanks(&s1, &s2, 1, &tol, &result);
+    printVerify(name1, name2, &result);
 }
 
 // function to generate graph of a given size without duplicate edges
 void generateRandomGraph(Graph *graph) {
-    srand(time(NULL));
-    // prob per edge to get avg M/N
-    double p = (double)M / (N * (N - 1));
-
-    for (int i = 0; i < N; i++) {
-        for (int j = 0; j < N; j++) {
-            // add edge with prob p
-            if (i != j && ((double)rand() / RAND_MAX) < p) {
-                addEdge(graph, i, j);
-            }
-        }
+    // expected M edges in O(N + M), the same graph on every run
+    EdgeList *edges = generateErdosRenyi(N, M, SEED, T);
+    for (long e = 0; e < edges->numEdges; e++) {
+        addEdge(graph, edges->src[e], edges->dst[e]);
     }
+    freeEdgeList(edges);
 }
 
 float t1 (Graph* graph) {
@@ -267,6 +315,7 @@ int main()
     // Initialize the graph
     Graph *graph = createGraph(N);
     generateRandomGraph(graph);
+    initBench(&ranksBench, "main3-ranks", 0, BI);
     
     printf("\n");
     benchmark(graph, PageRank, "serial");
@@ -279,29 +328,12 @@ int main()
     compare2(graph, t1, t2, "sum-serial", "sum-parallel");
     printf("\n");
 
-    // Free allocated memory
-    for (int i = 0; i < N; i++)
-    {
-        node* adjList = graph->adjacencyListsOut[i];
-        while (adjList != NULL)
-        {
-            node* temp = adjList;
-            adjList = adjList->next;
-            free(temp);
-        }
+    writeBenchCSV(&ranksBench, "main3-ranks.csv");
+    writeBenchJSON(&ranksBench, "main3-ranks.json");
+    freeBench(&ranksBench);
 
-        adjList = graph->adjacencyListsIn[i];
-        while (adjList != NULL)
-        {
-            node* temp = adjList;
-            adjList = adjList->next;
-            free(temp);
-        }
-    }
-
-    free(graph->adjacencyListsOut);
-    free(graph->adjacencyListsIn);
-    free(graph);
+    // Free allocated memory
+    freeGraph(graph);
 
     return 0;
 }
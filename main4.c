@@ -1,18 +1,23 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "graph.h"
+#include "generator.h"
+#include "bench.h"
+#include "verify.h"
 #include <time.h>
 #include <pthread.h>
 #include <math.h>
+#include <string.h>
 
 #define N 10000     // node count
 #define M 20     // edge count
+#define SEED 1   // picks the random graph
 #define D 0.15   // damping factor
 #define I 100    // iterations count
-#define BI 10000 // benchmark iterations
-#define TC 4     // thread count
+#define TOL 0.0  // stop once an iteration moves the ranks less than this (L1), 0 runs all I
+#define BI 10    // benchmark repetitions, after one warmup
+#define TC 4     // default thread count, ./main4 [threads] overrides it
 #define BLOCK_SIZE (64 / sizeof(float)) // should be 16
-#define EPSILON 0.00001
 
 typedef struct __attribute__((aligned(64))) e {
     float data [BLOCK_SIZE];
@@ -46,12 +51,17 @@ void printRanksStruct(e* ranks) {
     printf("\n");
 }
 
+// iterations the last kernel ran, less than I when it converged
+int iterationsRun = I;
+int threadCount = TC; // threads of t3
+
 void PageRank(Graph *graph, float* ranks) {
 
     float *newRanks = (float *)malloc(N * sizeof(float));
     int* outlinkes = (int*)calloc(N, sizeof(int));
 
     initializeRanks(ranks);
+    iterationsRun = I;
     
     //outlinks calculations
     
@@ -104,11 +114,14 @@ void PageRank(Graph *graph, float* ranks) {
 void GoodPageRank(Graph *graph, float* ranks) {
 
     float *newRanks = (float *)malloc(N * sizeof(float));
+    float *out = ranks;
     initializeRanks(ranks);
 
+    iterationsRun = I;
     for (int iter = 0; iter < I; iter++) {
 
         double sumB = 0.0;
+        double residual = 0.0;
         // calculate the sum of ranks of those without outlinks
         for (int i=0; i < N; i++) {
             // dont divide outside for precision
@@ -126,12 +139,24 @@ void GoodPageRank(Graph *graph, float* ranks) {
                 u = u->next;
             }
             newRanks[i] = D/N +(1-D)*(sumA+sumB);
+            residual += fabs(newRanks[i] - ranks[i]);
         }
 
         // pointer switching instead of slow assignment
         float* temp = newRanks;
         newRanks = ranks;
         ranks = temp;
+
+        if (residual < TOL) {
+            iterationsRun = iter + 1;
+            break;
+        }
+    }
+
+    // an odd number of switches leaves the result in our buffer
+    if (ranks != out) {
+        memcpy(out, ranks, N * sizeof(float));
+        newRanks = ranks;
     }
 
     free(newRanks);
@@ -141,11 +166,14 @@ void GoodPageRank(Graph *graph, float* ranks) {
 void ParallelPageRank(Graph *graph, float *ranks)
 {
     float *newRanks = (float *)malloc(N * sizeof(float));
+    float *out = ranks;
     initializeRanks(ranks);
 
+    iterationsRun = I;
     for (int iter = 0; iter < I; iter++) {
 
         double sumB = 0.0;
+        double residual = 0.0;
         // calculate the sum of ranks of those without outlinks
         for (int i=0; i < N; i++) {
             // dont divide outside for precision
@@ -163,48 +191,73 @@ void ParallelPageRank(Graph *graph, float *ranks)
                 u = u->next;
             }
             newRanks[i] = D/N +(1-D)*(sumA+sumB);
+            residual += fabs(newRanks[i] - ranks[i]);
         }
 
         // pointer switching instead of slow assignment
         float* temp = newRanks;
         newRanks = ranks;
         ranks = temp;
+
+        if (residual < TOL) {
+            iterationsRun = iter + 1;
+            break;
+        }
+    }
+
+    // an odd number of switches leaves the result in our buffer
+    if (ranks != out) {
+        memcpy(out, ranks, N * sizeof(float));
+        newRanks = ranks;
     }
 
     free(newRanks);
 }
 
+Bench ranksBench; // benchmark rows, speedups against the first
+
+typedef struct RankRun {
+    Graph* graph;
+    void (*f)(Graph*, float*);
+    float* ranks;
+} RankRun;
+
+void runRanks(void* ctx) {
+    RankRun* run = (RankRun*)ctx;
+    run->f(run->graph, run->ranks);
+}
+
 void benchmark(Graph* graph, void (*f)(Graph*, float*), char* name) {
     float *ranks = (float *)calloc(N, sizeof(float));
-    double start, end, total = 0;
-
-    start = (double)clock() / CLOCKS_PER_SEC;
+    RankRun run = {graph, f, ranks};
 
+    // the warmup run, and it tells how many iterations the timed ones do
     f(graph, ranks);
+    long edges = 0;
+    for (int i = 0; i < N; i++) edges += graph->adjacencyListsInLength[i];
 
-    end = (double)clock() / CLOCKS_PER_SEC;
-    total += (end - start);
-    // Print the ranks
-    // for (int i = 0; i < N; i++) { printf("Rank of node %d: %f\n", i, ranks[i]); }
-    printf("time to calc %-9s  \e[1m%lf\e[m\n", name, total);   
+    benchRun(&ranksBench, name, runRanks, &run, (double)edges * iterationsRun, "edges");
     free(ranks);
 }
 
-void benchmark2(Graph* graph, float (*f)(Graph*), char* name) {
-    double start, end, total = 0;
+Bench sumsBench; // benchmark2 rows, speedups against the first
 
-    // for (int i=0; i < BI; i++) {
-        start = (double)clock() / CLOCKS_PER_SEC;
+typedef struct SumRun {
+    Graph* graph;
+    float (*f)(Graph*);
+} SumRun;
 
-        f(graph);
+void runSum(void* ctx) {
+    SumRun* run = (SumRun*)ctx;
+    run->f(run->graph);
+}
 
-        end = (double)clock() / CLOCKS_PER_SEC;
-        total += (end - start);
-    // }
-    
-    printf("time to calc %-12s  \e[1m%lf\e[m\n", name, total);   
+void benchmark2(Graph* graph, float (*f)(Graph*), char* name) {
+    SumRun run = {graph, f};
+    benchRun(&sumsBench, name, runSum, &run, (double)N * I, "vertices");
 }
 
+// ranks up to rounding, and the orderings they give
 void compare(Graph* graph, void (*f1)(Graph*, float*), void (*f2)(Graph*, float*), char* name1, char* name2) {
     float *ranks1 = (float *)calloc(N, sizeof(float));
     float *ranks2 = (float *)calloc(N, sizeof(float));
@@ -212,39 +265,34 @@ void compare(Graph* graph, void (*f1)(Graph*, float*), void (*f2)(Graph*, float*
     f1(graph, ranks1);
     f2(graph, ranks2);
 
-    int same = 1;
-    for (int i=0; i < N; i++) {
-        if (ranks1[i] != ranks2[i]) same = 0;
-    }
-    // some terminal sugar
-    printf("%-6s and %-8s are \e[1m%s\e[m\n", name1, name2, (same == 0 ? "different" : "equal"));
+    Tolerance tol;
+    initTolerance(&tol);
+    VerifyResult result;
+    verifyRanks(ranks1, ranks2, N, &tol, &result);
+    printVerify(name1, name2, &result);
     free(ranks1); free(ranks2);
 }
 
+// sums up to rounding, a reordered parallel sum rarely matches bit for bit
 void compare2(Graph* graph, float (*f1)(Graph*), float (*f2)(Graph*), char* name1, char* name2) {
-
     float s1 = f1(graph);
     float s2 = f2(graph);
 
-    int same = (s1 - s2) < EPSILON;
-    // some terminal sugar
-    printf("%-6s and %-8s are \e[1m%s\e[m\n", name1, name2, (same == 0 ? "different" : "equal"));
+    Tolerance tol;
+    initTolerance(&tol);
+    VerifyResult result;
+    verifyRanks(&s1, &s2, 1, &tol, &result);
+    printVerify(name1, name2, &result);
 }
 
 // function to generate graph of a given size without duplicate edges
 void generateRandomGraph(Graph *graph) {
-    srand(time(NULL));
-    // prob per edge to get avg M/N
-    double p = (double)M / (N * (N - 1));
-
-    for (int i = 0; i < N; i++) {
-        for (int j = 0; j < N; j++) {
-            // add edge with prob p
-            if (i != j && ((double)rand() / RAND_MAX) < p) {
-                addEdge(graph, i, j);
-            }
-        }
+    // expected M edges in O(N + M), the same graph on every run
+    EdgeList *edges = generateErdosRenyi(N, M, SEED, TC);
+    for (long e = 0; e < edges->numEdges; e++) {
+        addEdge(graph, edges->src[e], edges->dst[e]);
     }
+    freeEdgeList(edges);
 }
 
 float t1 (Graph* graph) {
@@ -324,14 +372,14 @@ float t3 (Graph* graph) {
     float sumB = 0.0;
     pthread_cond_t cond;
 
-    pthread_t threads [TC];
-    worker_args_t args [TC];
+    pthread_t threads [threadCount];
+    worker_args_t args [threadCount];
 
     initializeRanksStruct(ranks);
     // printRanksStruct(ranks);
-    int step = (ceil+TC-1) / TC;
+    int step = (ceil+threadCount-1) / threadCount;
     int start = 0, end = 0;
-    for (int i=0; i < TC; i++) {
+    for (int i=0; i < threadCount; i++) {
         end += step;
         args[i].graph=graph; args[i].ranks=ranks; args[i].start=start; args[i].end=end; args[i].mutex=&mutex; args[i].sum=0.0; args[i].id = i;
         if (pthread_create(&threads[i], NULL, worker_t3, &args[i]) != 0) {
@@ -342,7 +390,7 @@ float t3 (Graph* graph) {
         start = end;    
     }
 
-    for (int i=0; i < TC; i++) {
+    for (int i=0; i < threadCount; i++) {
         pthread_join(threads[i], NULL);
         sumB += args[i].sum;
     }
@@ -350,11 +398,16 @@ float t3 (Graph* graph) {
     return sumB;
 }
 
-int main()
+int main(int argc, char** argv)
 {
+    if (argc > 1) threadCount = atoi(argv[1]);
+    if (threadCount < 1) threadCount = 1;
+
     // Initialize the graph
     Graph *graph = createGraph(N);
     generateRandomGraph(graph);
+    initBench(&ranksBench, "main4-ranks", 0, BI);
+    initBench(&sumsBench, "main4-sums", 1, BI);
     
     printf("\n");
     // benchmark(graph, PageRank, "serial");
@@ -372,29 +425,13 @@ int main()
     compare2(graph, t2, t3, "sum-good", "sum-parallel");
     printf("\n");
 
-    // Free allocated memory
-    for (int i = 0; i < N; i++)
-    {
-        node* adjList = graph->adjacencyListsOut[i];
-        while (adjList != NULL)
-        {
-            node* temp = adjList;
-            adjList = adjList->next;
-            free(temp);
-        }
-
-        adjList = graph->adjacencyListsIn[i];
-        while (adjList != NULL)
-        {
-            node* temp = adjList;
-            adjList = adjList->next;
-            free(temp);
-        }
-    }
+    writeBenchCSV(&sumsBench, "main4-sums.csv");
+    writeBenchJSON(&sumsBench, "main4-sums.json");
+    freeBench(&ranksBench);
+    freeBench(&sumsBench);
 
-    free(graph->adjacencyListsOut);
-    free(graph->adjacencyListsIn);
-    free(graph);
+    // Free allocated memory
+    freeGraph(graph);
 
     return 0;
 }
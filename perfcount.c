@@ -0,0 +1,236 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include "perfcount.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+static const char* eventNames[PERF_EVENTS] = {
+    "task clock", "cycles", "instructions", "LLC misses", "dTLB misses", "stalled cycles",
+};
+
+// the session every thread counts into, one at a time
+static struct {
+    int active;
+    int warned;      // missing events are printed by the first session only
+    int generation;  // threads reopen their group when it changes
+    const char** phaseNames;
+    int phases;
+    PerfThread* threads[PERF_MAX_THREADS];
+    atomic_int threadCount;
+} session;
+
+// this thread's group, valid while generation is the session's
+static __thread PerfThread* current;
+static __thread int currentGeneration;
+
+#ifdef __linux__
+static int openEvent(int event, int groupFd) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    switch (event) {
+    case PERF_TASK_CLOCK:
+        attr.type = PERF_TYPE_SOFTWARE;
+        attr.config = PERF_COUNT_SW_TASK_CLOCK;
+        break;
+    case PERF_CYCLES:       attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+    case PERF_INSTRUCTIONS: attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+    case PERF_STALLED:      attr.config = PERF_COUNT_HW_STALLED_CYCLES_BACKEND; break;
+    case PERF_LLC_MISSES:
+    case PERF_DTLB_MISSES:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = (event == PERF_LLC_MISSES ? PERF_COUNT_HW_CACHE_LL : PERF_COUNT_HW_CACHE_DTLB) |
+                      (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        break;
+    }
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    // pid 0 and cpu -1 follow the calling thread wherever it runs
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0);
+}
+#endif
+
+// opens the calling thread's group, errors[event] gets the errno of each event that failed
+static PerfThread* openThread(int* errors) {
+    PerfThread* thread = (PerfThread*)calloc(1, sizeof(PerfThread));
+    if (!thread) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    thread->leader = -1;
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        thread->fd[e] = -1;
+        thread->slot[e] = -1;
+#ifdef __linux__
+        thread->fd[e] = openEvent(e, thread->leader);
+#else
+        errno = ENOSYS;
+#endif
+        if (thread->fd[e] < 0) {
+            if (errors) errors[e] = errno;
+            continue;
+        }
+        if (thread->leader < 0) thread->leader = thread->fd[e];
+        thread->slot[e] = thread->count++;
+    }
+    return thread;
+}
+
+// time enabled, time running and the values into out, by event
+static int readThread(PerfThread* thread, uint64_t* out) {
+    // nr, time enabled, time running, one value per group member
+    uint64_t buf[3 + PERF_EVENTS];
+    ssize_t size = (ssize_t)((3 + thread->count) * sizeof(uint64_t));
+    if (read(thread->leader, buf, size) != size) return -1;
+    out[0] = buf[1];
+    out[1] = buf[2];
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        out[2 + e] = thread->slot[e] >= 0 ? buf[3 + thread->slot[e]] : 0;
+    }
+    return 0;
+}
+
+int perfBegin(const char** phaseNames, int phases) {
+    if (session.active) perfEnd();
+    session.phaseNames = phaseNames;
+    session.phases = phases < PERF_MAX_PHASES ? phases : PERF_MAX_PHASES;
+    session.generation++;
+    atomic_store(&session.threadCount, 0);
+
+    // the calling thread opens first, its failures stand for every thread's
+    int errors[PERF_EVENTS] = {0};
+    PerfThread* thread = openThread(errors);
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        if (thread->fd[e] < 0 && !session.warned) {
+            printf("perf: %s not counted, %s\n", eventNames[e], strerror(errors[e]));
+        }
+    }
+    session.warned = 1;
+    if (thread->count == 0) {
+        free(thread);
+        return -1;
+    }
+    current = thread;
+    currentGeneration = session.generation;
+    session.threads[atomic_fetch_add(&session.threadCount, 1)] = thread;
+    session.active = 1;
+    return 0;
+}
+
+void perfStart(void) {
+    if (!session.active) return;
+    if (currentGeneration != session.generation) {
+        currentGeneration = session.generation;
+        current = NULL;
+        int index = atomic_fetch_add(&session.threadCount, 1);
+        if (index >= PERF_MAX_THREADS) return;
+        PerfThread* thread = openThread(NULL);
+        if (thread->count == 0) {
+            free(thread);
+            thread = NULL;
+        }
+        // an empty slot is skipped by the report
+        session.threads[index] = thread;
+        current = thread;
+    }
+    if (current != NULL) readThread(current, current->last);
+}
+
+void perfLap(int phase) {
+    if (!session.active || current == NULL || currentGeneration != session.generation) return;
+    if (phase < 0 || phase >= session.phases) return;
+    uint64_t now[PERF_EVENTS + 2];
+    if (readThread(current, now) != 0) return;
+    for (int k = 0; k < PERF_EVENTS + 2; k++) {
+        current->phase[phase][k] += now[k] - current->last[k];
+        current->last[k] = now[k];
+    }
+}
+
+// estimates of what the event would have counted if it had run all the time enabled
+static void scaledCounts(uint64_t* raw, double* counts) {
+    double scale = raw[1] ? (double)raw[0] / raw[1] : 0.0;
+    for (int e = 0; e < PERF_EVENTS; e++) counts[e] = raw[2 + e] * scale;
+}
+
+static void printRow(const char* label, double* counts, int* available, double edges) {
+    printf("%-14s", label);
+    if (available[PERF_TASK_CLOCK]) printf("  %10.2lf", counts[PERF_TASK_CLOCK] * 1e-6);
+    else printf("  %10s", "n/a");
+    if (available[PERF_CYCLES]) printf("  %10.4lf", counts[PERF_CYCLES] * 1e-9);
+    else printf("  %10s", "n/a");
+    if (available[PERF_CYCLES] && available[PERF_INSTRUCTIONS] && counts[PERF_CYCLES] > 0) {
+        printf("  %6.2lf", counts[PERF_INSTRUCTIONS] / counts[PERF_CYCLES]);
+    } else {
+        printf("  %6s", "n/a");
+    }
+    for (int e = PERF_LLC_MISSES; e <= PERF_DTLB_MISSES; e++) {
+        if (available[e] && edges > 0) printf("  %10.4lf", counts[e] / edges);
+        else printf("  %10s", "n/a");
+    }
+    if (available[PERF_STALLED] && available[PERF_CYCLES] && counts[PERF_CYCLES] > 0) {
+        printf("  %6.1lf%%\n", 100.0 * counts[PERF_STALLED] / counts[PERF_CYCLES]);
+    } else {
+        printf("  %7s\n", "n/a");
+    }
+}
+
+void perfReport(double edges) {
+    if (!session.active) return;
+    int threads = atomic_load(&session.threadCount);
+    if (threads > PERF_MAX_THREADS) threads = PERF_MAX_THREADS;
+
+    // an event counts as available when any thread has it
+    int available[PERF_EVENTS] = {0};
+    for (int t = 0; t < threads; t++) {
+        if (session.threads[t] == NULL) continue;
+        for (int e = 0; e < PERF_EVENTS; e++) available[e] |= session.threads[t]->fd[e] >= 0;
+    }
+
+    printf("%-14s  %10s  %10s  %6s  %10s  %10s  %7s\n", "phase", "cpu ms", "Gcycles", "IPC",
+           "LLC/edge", "dTLB/edge", "stalled");
+    for (int p = 0; p < session.phases; p++) {
+        double total[PERF_EVENTS] = {0}, counts[PERF_EVENTS];
+        for (int t = 0; t < threads; t++) {
+            if (session.threads[t] == NULL) continue;
+            scaledCounts(session.threads[t]->phase[p], counts);
+            for (int e = 0; e < PERF_EVENTS; e++) total[e] += counts[e];
+        }
+        printRow(session.phaseNames[p], total, available, edges);
+
+        // threads that spent time in the phase, in the order they joined
+        for (int t = 0; t < threads; t++) {
+            if (session.threads[t] == NULL || session.threads[t]->phase[p][0] == 0) continue;
+            char label[32];
+            snprintf(label, sizeof(label), "  thread %d", t);
+            scaledCounts(session.threads[t]->phase[p], counts);
+            printRow(label, counts, available, edges);
+        }
+    }
+}
+
+void perfEnd(void) {
+    int threads = atomic_load(&session.threadCount);
+    if (threads > PERF_MAX_THREADS) threads = PERF_MAX_THREADS;
+    for (int t = 0; t < threads; t++) {
+        PerfThread* thread = session.threads[t];
+        if (thread == NULL) continue;
+        for (int e = 0; e < PERF_EVENTS; e++) {
+            if (thread->fd[e] >= 0) close(thread->fd[e]);
+        }
+        free(thread);
+        session.threads[t] = NULL;
+    }
+    atomic_store(&session.threadCount, 0);
+    session.active = 0;
+    current = NULL;
+}
@@ -0,0 +1,58 @@
+#ifndef PERFCOUNT_H
+#define PERFCOUNT_H
+
+#include <stdint.h>
+
+#define PERF_MAX_PHASES  8
+#define PERF_MAX_THREADS 256 // threads past this are not counted
+
+// events of a group, in the order of PerfThread.values
+#define PERF_TASK_CLOCK   0 // nanoseconds on the cpu, software, works without a PMU
+#define PERF_CYCLES       1
+#define PERF_INSTRUCTIONS 2
+#define PERF_LLC_MISSES   3 // last level cache read misses
+#define PERF_DTLB_MISSES  4 // data TLB read misses
+#define PERF_STALLED      5 // backend stalled cycles, not on every cpu
+#define PERF_EVENTS       6
+
+/*
+ * Per thread hardware counters around the phases of a kernel, read straight
+ * through perf_event_open. A thread opens its counter group the first time it
+ * calls perfStart inside a session. perfLap reads the group once and adds
+ * what it counted since the last read to one phase, so back to back phases
+ * cost one read each. Outside a session, or where the kernel refuses the
+ * events, both return at once. Events this cpu doesn't have are left out and
+ * reported as n/a. Only user space is counted.
+ */
+struct PerfThread {
+    int fd[PERF_EVENTS];    // -1 when the event couldn't be opened
+    int slot[PERF_EVENTS];  // position in the group read, -1 likewise
+    int leader;
+    int count;              // events in the group
+    // time enabled, time running, then one value per event
+    uint64_t last[PERF_EVENTS + 2];
+    uint64_t phase[PERF_MAX_PHASES][PERF_EVENTS + 2];
+};
+
+typedef struct PerfThread PerfThread;
+
+/*
+ * Starts a session for phases named phaseNames. Returns 0, or -1 with the
+ * reason printed when perf_event_open isn't usable here, in which case the
+ * caller may still run its kernels, they just go uncounted.
+ */
+int perfBegin(const char** phaseNames, int phases);
+
+// snapshot of the calling thread's counters, the next lap counts from here
+void perfStart(void);
+
+// adds the events since the last perfStart or perfLap of this thread to phase
+void perfLap(int phase);
+
+// per phase totals and per thread rows, misses per edge are over edges
+void perfReport(double edges);
+
+// closes every thread's counters, the threads must be done with the session
+void perfEnd(void);
+
+#endif
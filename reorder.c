@@ -0,0 +1,297 @@
+#include <string.h>
+#include "reorder.h"
+
+static const char *orderNames[ORDER_METHODS] = {"in-degree", "out-degree", "rcm", "gorder"};
+
+const char *orderName(int method) {
+    return (method >= 0 && method < ORDER_METHODS) ? orderNames[method] : "none";
+}
+
+static inline int inDegree(CSRGraph *csr, int v) {
+    return (int)(csr->inOffsets[v + 1] - csr->inOffsets[v]);
+}
+
+// vertices by descending degree, ties by id, with a counting sort
+static int *degreeOrder(CSRGraph *csr, int in) {
+    int n = csr->numVertices;
+    int maxDegree = 0;
+    for (int v = 0; v < n; v++) {
+        int d = in ? inDegree(csr, v) : csr->outDegree[v];
+        if (d > maxDegree) maxDegree = d;
+    }
+    long *start = (long *)calloc(maxDegree + 2, sizeof(long));
+    if (!start) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    // bucket maxDegree - d, so the highest degree comes first
+    for (int v = 0; v < n; v++) start[maxDegree - (in ? inDegree(csr, v) : csr->outDegree[v]) + 1]++;
+    for (int b = 1; b <= maxDegree + 1; b++) start[b] += start[b - 1];
+
+    int *newId = (int *)malloc(n * sizeof(int));
+    if (!newId) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    for (int v = 0; v < n; v++) newId[v] = (int)start[maxDegree - (in ? inDegree(csr, v) : csr->outDegree[v])]++;
+    free(start);
+    return newId;
+}
+
+static int compareKeys(const void *a, const void *b) {
+    unsigned long x = *(const unsigned long *)a, y = *(const unsigned long *)b;
+    return (x > y) - (x < y);
+}
+
+static int *rcmOrder(CSRGraph *csr) {
+    int n = csr->numVertices;
+    int *order = (int *)malloc(n * sizeof(int));
+    char *visited = (char *)calloc(n, 1);
+    // start candidates by ascending degree in both directions, ties by id
+    unsigned long *keys = (unsigned long *)malloc(n * sizeof(unsigned long));
+    unsigned long *next = (unsigned long *)malloc(n * sizeof(unsigned long));
+    if (!order || !visited || !keys || !next) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    for (int v = 0; v < n; v++) keys[v] = ((unsigned long)(inDegree(csr, v) + csr->outDegree[v]) << 32) | v;
+    qsort(keys, n, sizeof(unsigned long), compareKeys);
+
+    int tail = 0;
+    for (int s = 0; s < n; s++) {
+        int root = (int)(keys[s] & 0xffffffff);
+        if (visited[root]) continue;
+        visited[root] = 1;
+        order[tail++] = root;
+        // order doubles as the queue, every component is numbered breadth first
+        for (int head = tail - 1; head < tail; head++) {
+            int v = order[head];
+            int count = 0;
+            for (long k = csr->inOffsets[v]; k < csr->inOffsets[v + 1]; k++) {
+                int u = csr->inNeighbors[k];
+                if (visited[u]) continue;
+                visited[u] = 1;
+                next[count++] = ((unsigned long)(inDegree(csr, u) + csr->outDegree[u]) << 32) | u;
+            }
+            for (long k = csr->outOffsets[v]; k < csr->outOffsets[v + 1]; k++) {
+                int u = csr->outNeighbors[k];
+                if (visited[u]) continue;
+                visited[u] = 1;
+                next[count++] = ((unsigned long)(inDegree(csr, u) + csr->outDegree[u]) << 32) | u;
+            }
+            // lower degree neighbors first
+            qsort(next, count, sizeof(unsigned long), compareKeys);
+            for (int i = 0; i < count; i++) order[tail++] = (int)(next[i] & 0xffffffff);
+        }
+    }
+
+    // reversed, the order was the Cuthill-McKee one
+    int *newId = (int *)malloc(n * sizeof(int));
+    if (!newId) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    for (int i = 0; i < n; i++) newId[order[i]] = n - 1 - i;
+    free(order);
+    free(visited);
+    free(keys);
+    free(next);
+    return newId;
+}
+
+/*
+ * Max priority queue over the unplaced vertices for keys that only move by
+ * one: a doubly linked list per key, so raising or lowering a key is an
+ * unlink and a push, and top only has to walk down past emptied lists.
+ */
+typedef struct UnitHeap {
+    int *key;
+    int *prev;
+    int *next;
+    int *head;    // first vertex of each key, -1 when none
+    int capacity; // entries of head
+    int top;      // no vertex has a higher key
+} UnitHeap;
+
+static void unlinkVertex(UnitHeap *heap, int v) {
+    if (heap->prev[v] >= 0) heap->next[heap->prev[v]] = heap->next[v];
+    else heap->head[heap->key[v]] = heap->next[v];
+    if (heap->next[v] >= 0) heap->prev[heap->next[v]] = heap->prev[v];
+}
+
+static void pushVertex(UnitHeap *heap, int v) {
+    int k = heap->key[v];
+    if (k >= heap->capacity) {
+        int capacity = heap->capacity * 2 > k + 1 ? heap->capacity * 2 : k + 1;
+        heap->head = (int *)realloc(heap->head, capacity * sizeof(int));
+        if (!heap->head) {
+            printf("Memory allocation failed\n");
+            exit(1);
+        }
+        for (int i = heap->capacity; i < capacity; i++) heap->head[i] = -1;
+        heap->capacity = capacity;
+    }
+    heap->prev[v] = -1;
+    heap->next[v] = heap->head[k];
+    if (heap->head[k] >= 0) heap->prev[heap->head[k]] = v;
+    heap->head[k] = v;
+    if (k > heap->top) heap->top = k;
+}
+
+// placed vertices have key -1 and are left alone
+static inline void updateKey(UnitHeap *heap, int v, int delta) {
+    if (heap->key[v] < 0) return;
+    unlinkVertex(heap, v);
+    heap->key[v] += delta;
+    pushVertex(heap, v);
+}
+
+// scores of the vertices related to v, when v enters (+1) or leaves (-1) the window
+static void updateWindow(CSRGraph *csr, UnitHeap *heap, int v, int delta, int hub) {
+    for (long k = csr->outOffsets[v]; k < csr->outOffsets[v + 1]; k++) {
+        updateKey(heap, csr->outNeighbors[k], delta);
+    }
+    for (long k = csr->inOffsets[v]; k < csr->inOffsets[v + 1]; k++) {
+        int u = csr->inNeighbors[k];
+        updateKey(heap, u, delta);
+        if (csr->outDegree[u] > hub) continue;
+        // siblings, the other vertices u links to
+        for (long j = csr->outOffsets[u]; j < csr->outOffsets[u + 1]; j++) {
+            if (csr->outNeighbors[j] != v) updateKey(heap, csr->outNeighbors[j], delta);
+        }
+    }
+}
+
+static int *gorderOrder(CSRGraph *csr) {
+    int n = csr->numVertices;
+    int hub = GORDER_HUB;
+    UnitHeap heap;
+    heap.key = (int *)calloc(n, sizeof(int));
+    heap.prev = (int *)malloc(n * sizeof(int));
+    heap.next = (int *)malloc(n * sizeof(int));
+    heap.capacity = 16;
+    heap.head = (int *)malloc(heap.capacity * sizeof(int));
+    heap.top = 0;
+    if (!heap.key || !heap.prev || !heap.next || !heap.head) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    for (int i = 0; i < heap.capacity; i++) heap.head[i] = -1;
+    // pushed in reverse so equal keys come out by ascending id
+    for (int v = n - 1; v >= 0; v--) pushVertex(&heap, v);
+
+    int *order = (int *)malloc(n * sizeof(int));
+    if (!order) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    int first = 0;
+    for (int v = 1; v < n; v++) {
+        if (inDegree(csr, v) > inDegree(csr, first)) first = v;
+    }
+    for (int i = 0; i < n; i++) {
+        int v = first;
+        if (i > 0) {
+            while (heap.head[heap.top] < 0) heap.top--;
+            v = heap.head[heap.top];
+        }
+        unlinkVertex(&heap, v);
+        heap.key[v] = -1;
+        order[i] = v;
+
+        updateWindow(csr, &heap, v, 1, hub);
+        if (i >= GORDER_WINDOW) updateWindow(csr, &heap, order[i - GORDER_WINDOW], -1, hub);
+    }
+
+    int *newId = (int *)malloc(n * sizeof(int));
+    if (!newId) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    for (int i = 0; i < n; i++) newId[order[i]] = i;
+    free(order);
+    free(heap.key);
+    free(heap.prev);
+    free(heap.next);
+    free(heap.head);
+    return newId;
+}
+
+int *vertexOrder(CSRGraph *csr, int method) {
+    switch (method) {
+    case ORDER_IN_DEGREE:  return degreeOrder(csr, 1);
+    case ORDER_OUT_DEGREE: return degreeOrder(csr, 0);
+    case ORDER_RCM:        return rcmOrder(csr);
+    case ORDER_GORDER:     return gorderOrder(csr);
+    }
+    fprintf(stderr, "vertexOrder: unknown method %d\n", method);
+    return NULL;
+}
+
+CSRGraph *permuteCSRGraph(CSRGraph *csr, const int *newId) {
+    int n = csr->numVertices;
+    long m = csr->numEdges;
+    int *oldId = (int *)malloc(n * sizeof(int));
+    if (!oldId) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    for (int v = 0; v < n; v++) oldId[newId[v]] = v;
+
+    CSRGraph *out = (CSRGraph *)malloc(sizeof(CSRGraph));
+    if (!out) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    out->numVertices = n;
+    out->numEdges = m;
+    out->mapping = NULL;
+    out->mappingSize = 0;
+    out->inOffsets = (long *)malloc((n + 1) * sizeof(long));
+    out->outOffsets = (long *)malloc((n + 1) * sizeof(long));
+    out->outDegree = (int *)malloc(n * sizeof(int));
+    // +1 so an edgeless graph still gets a valid pointer
+    out->inNeighbors = (vertex *)malloc((m + 1) * sizeof(vertex));
+    out->outNeighbors = (vertex *)malloc((m + 1) * sizeof(vertex));
+    if (!out->inOffsets || !out->outOffsets || !out->outDegree || !out->inNeighbors || !out->outNeighbors) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+
+    out->inOffsets[0] = 0;
+    out->outOffsets[0] = 0;
+    for (int v = 0; v < n; v++) {
+        int old = oldId[v];
+        out->inOffsets[v + 1] = out->inOffsets[v] + inDegree(csr, old);
+        out->outOffsets[v + 1] = out->outOffsets[v] + csr->outDegree[old];
+        out->outDegree[v] = csr->outDegree[old];
+    }
+
+    // walking the sources in new id order appends every list already sorted
+    long *inFill = (long *)malloc(n * sizeof(long));
+    long *outFill = (long *)malloc(n * sizeof(long));
+    if (!inFill || !outFill) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    memcpy(inFill, out->inOffsets, n * sizeof(long));
+    memcpy(outFill, out->outOffsets, n * sizeof(long));
+    for (int v = 0; v < n; v++) {
+        int old = oldId[v];
+        for (long k = csr->outOffsets[old]; k < csr->outOffsets[old + 1]; k++) {
+            out->inNeighbors[inFill[newId[csr->outNeighbors[k]]]++] = v;
+        }
+        for (long k = csr->inOffsets[old]; k < csr->inOffsets[old + 1]; k++) {
+            out->outNeighbors[outFill[newId[csr->inNeighbors[k]]]++] = v;
+        }
+    }
+
+    free(inFill);
+    free(outFill);
+    free(oldId);
+    return out;
+}
+
+void unpermuteRanks(const float *ranks, const int *newId, int n, float *out) {
+    for (int v = 0; v < n; v++) out[v] = ranks[newId[v]];
+}
@@ -0,0 +1,41 @@
+#ifndef REORDER_H
+#define REORDER_H
+
+#include "graph.h"
+
+#define ORDER_IN_DEGREE  0 // most in-edges first
+#define ORDER_OUT_DEGREE 1 // most out-edges first, the ranks the pull gathers read most
+#define ORDER_RCM        2 // reverse Cuthill-McKee over both directions
+#define ORDER_GORDER     3 // greedy window ordering after Gorder
+#define ORDER_METHODS    4
+
+#define GORDER_WINDOW 5 // vertices a new one is scored against
+#define GORDER_HUB    8 // in-neighbors with more out-edges don't make siblings
+
+/*
+ * Vertex relabeling for locality. An order is a permutation newId[old], the
+ * graph is rebuilt under it with every neighbor list sorted by new id, the
+ * engines run on that graph unchanged and the ranks are mapped back to the
+ * original ids with unpermuteRanks.
+ *
+ * The degree orders pack the vertices read most into few cache lines. RCM
+ * is a breadth first numbering, so neighbors get nearby ids. The Gorder
+ * style order places vertices one at a time, each time picking the one
+ * sharing the most edges and in-neighbors with the last GORDER_WINDOW
+ * placed, as a bucketed priority queue with unit steps. In-neighbors with
+ * more than GORDER_HUB out-edges are not expanded into siblings, as Gorder
+ * does for hubs, or the cost grows with the square of their degree.
+ */
+
+const char * orderName(int method);
+
+// newId[old] for every vertex, in O(n + m), O(n log n + m) for RCM
+int * vertexOrder(CSRGraph *csr, int method);
+
+// csr under newId, neighbor lists in ascending new id
+CSRGraph * permuteCSRGraph(CSRGraph *csr, const int *newId);
+
+// out[v] = ranks[newId[v]], ranks of the permuted graph in original ids
+void unpermuteRanks(const float *ranks, const int *newId, int n, float *out);
+
+#endif
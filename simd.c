@@ -0,0 +1,273 @@
+#include "simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_X86 1
+#endif
+
+void pullScalar(CSRGraph* csr, const float* contrib, const float* ranks, float* newRanks,
+                int start, int end, float base, float scale, double* l1, double* linf) {
+    double sumL1 = 0.0, maxDiff = *linf;
+    for (int i = start; i < end; i++) {
+        double sumA = 0.0;
+        for (long k = csr->inOffsets[i]; k < csr->inOffsets[i+1]; k++) {
+            sumA += contrib[csr->inNeighbors[k]];
+        }
+        float rank = base + scale * sumA;
+        double diff = rank > ranks[i] ? rank - ranks[i] : ranks[i] - rank;
+        sumL1 += diff;
+        if (diff > maxDiff) maxDiff = diff;
+        newRanks[i] = rank;
+    }
+    *l1 += sumL1;
+    *linf = maxDiff;
+}
+
+void batchScalar(CSRGraph* csr, const float* contrib, float* sums, int K, int start, int end, float scale) {
+    for (int i = start; i < end; i++) {
+        float* out = sums + (long)i * K;
+        for (int q = 0; q < K; q++) out[q] = 0.0f;
+        for (long k = csr->inOffsets[i]; k < csr->inOffsets[i+1]; k++) {
+            const float* row = contrib + (long)csr->inNeighbors[k] * K;
+            for (int q = 0; q < K; q++) out[q] += row[q];
+        }
+        for (int q = 0; q < K; q++) out[q] *= scale;
+    }
+}
+
+#ifdef SIMD_X86
+
+__attribute__((target("avx2,fma")))
+static inline float hsum256(__m256 v) {
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_movehdup_ps(s));
+    return _mm_cvtss_f32(s);
+}
+
+// sum of contrib over one neighbor list, 8 lanes, the tail through a masked gather
+__attribute__((target("avx2,fma")))
+static inline float gatherSum256(const vertex* nb, long len, const float* contrib) {
+    __m256 acc = _mm256_setzero_ps();
+    long k = 0;
+    for (; k + 8 <= len; k += 8) {
+        __m256i idx = _mm256_loadu_si256((const __m256i*)(nb + k));
+        acc = _mm256_add_ps(acc, _mm256_i32gather_ps(contrib, idx, 4));
+    }
+    if (k < len) {
+        __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32((int)(len - k)), lane);
+        __m256i idx = _mm256_maskload_epi32((const int*)(nb + k), mask);
+        acc = _mm256_add_ps(acc, _mm256_mask_i32gather_ps(_mm256_setzero_ps(), contrib, idx,
+                                                          _mm256_castsi256_ps(mask), 4));
+    }
+    return hsum256(acc);
+}
+
+__attribute__((target("avx2,fma")))
+void pullAVX2(CSRGraph* csr, const float* contrib, const float* ranks, float* newRanks,
+              int start, int end, float base, float scale, double* l1, double* linf) {
+    const __m256 vbase = _mm256_set1_ps(base);
+    const __m256 vscale = _mm256_set1_ps(scale);
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256d vl1 = _mm256_setzero_pd();
+    __m256 vlinf = _mm256_setzero_ps();
+    float sums[8];
+
+    int i = start;
+    for (; i + 8 <= end; i += 8) {
+        for (int j = 0; j < 8; j++) {
+            long k = csr->inOffsets[i+j];
+            sums[j] = gatherSum256(csr->inNeighbors + k, csr->inOffsets[i+j+1] - k, contrib);
+        }
+        // epilogue for 8 vertices at once
+        __m256 rank = _mm256_fmadd_ps(vscale, _mm256_loadu_ps(sums), vbase);
+        __m256 diff = _mm256_and_ps(_mm256_sub_ps(rank, _mm256_loadu_ps(ranks + i)), absMask);
+        vl1 = _mm256_add_pd(vl1, _mm256_cvtps_pd(_mm256_castps256_ps128(diff)));
+        vl1 = _mm256_add_pd(vl1, _mm256_cvtps_pd(_mm256_extractf128_ps(diff, 1)));
+        vlinf = _mm256_max_ps(vlinf, diff);
+        _mm256_storeu_ps(newRanks + i, rank);
+    }
+
+    double lanes[4];
+    float maxLanes[8];
+    _mm256_storeu_pd(lanes, vl1);
+    _mm256_storeu_ps(maxLanes, vlinf);
+    *l1 += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (int j = 0; j < 8; j++) {
+        if (maxLanes[j] > *linf) *linf = maxLanes[j];
+    }
+
+    // fewer than 8 vertices left
+    pullScalar(csr, contrib, ranks, newRanks, i, end, base, scale, l1, linf);
+}
+
+__attribute__((target("avx512f,avx2,fma")))
+static inline float gatherSum512(const vertex* nb, long len, const float* contrib) {
+    // short lists are cheaper to reduce from 8 lanes
+    if (len <= 8) return gatherSum256(nb, len, contrib);
+
+    __m512 acc = _mm512_setzero_ps();
+    long k = 0;
+    for (; k + 16 <= len; k += 16) {
+        __m512i idx = _mm512_loadu_si512((const void*)(nb + k));
+        acc = _mm512_add_ps(acc, _mm512_i32gather_ps(idx, contrib, 4));
+    }
+    if (k < len) {
+        __mmask16 mask = (__mmask16)((1u << (len - k)) - 1);
+        __m512i idx = _mm512_maskz_loadu_epi32(mask, nb + k);
+        acc = _mm512_add_ps(acc, _mm512_mask_i32gather_ps(_mm512_setzero_ps(), mask, idx, contrib, 4));
+    }
+    return _mm512_reduce_add_ps(acc);
+}
+
+__attribute__((target("avx512f,avx2,fma")))
+void pullAVX512(CSRGraph* csr, const float* contrib, const float* ranks, float* newRanks,
+                int start, int end, float base, float scale, double* l1, double* linf) {
+    const __m512 vbase = _mm512_set1_ps(base);
+    const __m512 vscale = _mm512_set1_ps(scale);
+    __m512d vl1 = _mm512_setzero_pd();
+    __m512 vlinf = _mm512_setzero_ps();
+    float sums[16];
+
+    int i = start;
+    for (; i + 16 <= end; i += 16) {
+        for (int j = 0; j < 16; j++) {
+            long k = csr->inOffsets[i+j];
+            sums[j] = gatherSum512(csr->inNeighbors + k, csr->inOffsets[i+j+1] - k, contrib);
+        }
+        // epilogue for 16 vertices at once
+        __m512 rank = _mm512_fmadd_ps(vscale, _mm512_loadu_ps(sums), vbase);
+        __m512 diff = _mm512_abs_ps(_mm512_sub_ps(rank, _mm512_loadu_ps(ranks + i)));
+        vl1 = _mm512_add_pd(vl1, _mm512_cvtps_pd(_mm512_castps512_ps256(diff)));
+        vl1 = _mm512_add_pd(vl1, _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(diff), 1))));
+        vlinf = _mm512_max_ps(vlinf, diff);
+        _mm512_storeu_ps(newRanks + i, rank);
+    }
+
+    *l1 += _mm512_reduce_add_pd(vl1);
+    float maxDiff = _mm512_reduce_max_ps(vlinf);
+    if (maxDiff > *linf) *linf = maxDiff;
+
+    // fewer than 16 vertices left
+    pullScalar(csr, contrib, ranks, newRanks, i, end, base, scale, l1, linf);
+}
+
+// 32 queries in 4 registers per walk, then 8 at a time, then one at a time
+__attribute__((target("avx2,fma")))
+void batchAVX2(CSRGraph* csr, const float* contrib, float* sums, int K, int start, int end, float scale) {
+    const __m256 vscale = _mm256_set1_ps(scale);
+    for (int i = start; i < end; i++) {
+        const vertex* nb = csr->inNeighbors + csr->inOffsets[i];
+        long len = csr->inOffsets[i+1] - csr->inOffsets[i];
+        float* out = sums + (long)i * K;
+        int q = 0;
+        for (; q + 32 <= K; q += 32) {
+            __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps();
+            __m256 a2 = _mm256_setzero_ps(), a3 = _mm256_setzero_ps();
+            for (long k = 0; k < len; k++) {
+                const float* row = contrib + (long)nb[k] * K + q;
+                a0 = _mm256_add_ps(a0, _mm256_loadu_ps(row));
+                a1 = _mm256_add_ps(a1, _mm256_loadu_ps(row + 8));
+                a2 = _mm256_add_ps(a2, _mm256_loadu_ps(row + 16));
+                a3 = _mm256_add_ps(a3, _mm256_loadu_ps(row + 24));
+            }
+            _mm256_storeu_ps(out + q, _mm256_mul_ps(vscale, a0));
+            _mm256_storeu_ps(out + q + 8, _mm256_mul_ps(vscale, a1));
+            _mm256_storeu_ps(out + q + 16, _mm256_mul_ps(vscale, a2));
+            _mm256_storeu_ps(out + q + 24, _mm256_mul_ps(vscale, a3));
+        }
+        for (; q + 8 <= K; q += 8) {
+            __m256 a = _mm256_setzero_ps();
+            for (long k = 0; k < len; k++) a = _mm256_add_ps(a, _mm256_loadu_ps(contrib + (long)nb[k] * K + q));
+            _mm256_storeu_ps(out + q, _mm256_mul_ps(vscale, a));
+        }
+        for (; q < K; q++) {
+            float a = 0.0f;
+            for (long k = 0; k < len; k++) a += contrib[(long)nb[k] * K + q];
+            out[q] = scale * a;
+        }
+    }
+}
+
+// 64 queries in 4 registers per walk, then 16 at a time, the rest as AVX2 does it
+__attribute__((target("avx512f,avx2,fma")))
+void batchAVX512(CSRGraph* csr, const float* contrib, float* sums, int K, int start, int end, float scale) {
+    const __m512 vscale = _mm512_set1_ps(scale);
+    const __m256 vscale8 = _mm256_set1_ps(scale);
+    for (int i = start; i < end; i++) {
+        const vertex* nb = csr->inNeighbors + csr->inOffsets[i];
+        long len = csr->inOffsets[i+1] - csr->inOffsets[i];
+        float* out = sums + (long)i * K;
+        int q = 0;
+        for (; q + 64 <= K; q += 64) {
+            __m512 a0 = _mm512_setzero_ps(), a1 = _mm512_setzero_ps();
+            __m512 a2 = _mm512_setzero_ps(), a3 = _mm512_setzero_ps();
+            for (long k = 0; k < len; k++) {
+                const float* row = contrib + (long)nb[k] * K + q;
+                a0 = _mm512_add_ps(a0, _mm512_loadu_ps(row));
+                a1 = _mm512_add_ps(a1, _mm512_loadu_ps(row + 16));
+                a2 = _mm512_add_ps(a2, _mm512_loadu_ps(row + 32));
+                a3 = _mm512_add_ps(a3, _mm512_loadu_ps(row + 48));
+            }
+            _mm512_storeu_ps(out + q, _mm512_mul_ps(vscale, a0));
+            _mm512_storeu_ps(out + q + 16, _mm512_mul_ps(vscale, a1));
+            _mm512_storeu_ps(out + q + 32, _mm512_mul_ps(vscale, a2));
+            _mm512_storeu_ps(out + q + 48, _mm512_mul_ps(vscale, a3));
+        }
+        for (; q + 16 <= K; q += 16) {
+            __m512 a = _mm512_setzero_ps();
+            for (long k = 0; k < len; k++) a = _mm512_add_ps(a, _mm512_loadu_ps(contrib + (long)nb[k] * K + q));
+            _mm512_storeu_ps(out + q, _mm512_mul_ps(vscale, a));
+        }
+        for (; q + 8 <= K; q += 8) {
+            __m256 a = _mm256_setzero_ps();
+            for (long k = 0; k < len; k++) a = _mm256_add_ps(a, _mm256_loadu_ps(contrib + (long)nb[k] * K + q));
+            _mm256_storeu_ps(out + q, _mm256_mul_ps(vscale8, a));
+        }
+        for (; q < K; q++) {
+            float a = 0.0f;
+            for (long k = 0; k < len; k++) a += contrib[(long)nb[k] * K + q];
+            out[q] = scale * a;
+        }
+    }
+}
+
+#endif
+
+int simdLevel(void) {
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return SIMD_AVX512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return SIMD_AVX2;
+#endif
+    return SIMD_SCALAR;
+}
+
+PullKernel pullKernel(int level) {
+    int supported = simdLevel();
+    if (level > supported) level = supported;
+#ifdef SIMD_X86
+    if (level == SIMD_AVX512) return pullAVX512;
+    if (level == SIMD_AVX2) return pullAVX2;
+#endif
+    return pullScalar;
+}
+
+BatchKernel batchKernel(int level) {
+    int supported = simdLevel();
+    if (level > supported) level = supported;
+#ifdef SIMD_X86
+    if (level == SIMD_AVX512) return batchAVX512;
+    if (level == SIMD_AVX2) return batchAVX2;
+#endif
+    return batchScalar;
+}
+
+const char* simdLevelName(int level) {
+    switch (level) {
+        case SIMD_AVX512: return "avx512";
+        case SIMD_AVX2:   return "avx2";
+        default:          return "scalar";
+    }
+}
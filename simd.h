@@ -0,0 +1,42 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include "graph.h"
+
+#define SIMD_SCALAR 0
+#define SIMD_AVX2   1 // 8 gathers per instruction
+#define SIMD_AVX512 2 // 16 gathers per instruction
+
+/*
+ * Pull kernel over a CSR graph and a contribution vector, for start <= i < end:
+ *   newRanks[i] = base + scale * sum of contrib[u] over the in-neighbors u of i
+ * with base = D/N + (1-D)*sumB and scale = 1-D. It also adds |newRanks[i] - ranks[i]|
+ * to *l1 and raises *linf to the largest one.
+ * The vector versions sum in float, so they match the scalar double sums
+ * only up to rounding.
+ */
+typedef void (*PullKernel)(CSRGraph* csr, const float* contrib, const float* ranks, float* newRanks,
+                           int start, int end, float base, float scale, double* l1, double* linf);
+
+/*
+ * Batched pull kernel for K queries whose values are interleaved per vertex,
+ * value q of vertex v at v*K + q. For start <= i < end and every q:
+ *   sums[i*K + q] = scale * sum of contrib[u*K + q] over the in-neighbors u of i
+ * Each neighbor list is walked once per block of queries that fits in the
+ * vector registers, loading the K values of a neighbor as whole vectors.
+ */
+typedef void (*BatchKernel)(CSRGraph* csr, const float* contrib, float* sums, int K, int start, int end,
+                            float scale);
+
+// widest level the cpu supports (cpuid), SIMD_SCALAR off x86
+int simdLevel(void);
+
+// kernel for a level, falls back to the widest supported one below it
+PullKernel pullKernel(int level);
+
+// batched kernel for a level, same fallback as pullKernel
+BatchKernel batchKernel(int level);
+
+const char* simdLevelName(int level);
+
+#endif
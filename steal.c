@@ -0,0 +1,216 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include "steal.h"
+
+#define DEQUE_EMPTY -1
+
+typedef struct WorkerArgs {
+    StealPool* pool;
+    int id;
+} WorkerArgs;
+
+// owner only
+void dequePush(Deque* d, int task) {
+    long b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    atomic_store_explicit(&d->buffer[b & d->mask], task, memory_order_relaxed);
+    // release, a thief that sees the task also sees the round it belongs to
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_release);
+}
+
+// owner only, races thieves for the last task
+int dequePop(Deque* d) {
+    long b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    // every bottom store releases, thieves may read this one instead of the push's
+    atomic_store_explicit(&d->bottom, b, memory_order_release);
+    atomic_thread_fence(memory_order_seq_cst);
+    long t = atomic_load_explicit(&d->top, memory_order_relaxed);
+
+    if (t > b) {
+        // empty, restore bottom
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_release);
+        return DEQUE_EMPTY;
+    }
+
+    int task = atomic_load_explicit(&d->buffer[b & d->mask], memory_order_relaxed);
+    if (t == b) {
+        // last one, whoever moves top first gets it
+        if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1,
+                                                     memory_order_seq_cst, memory_order_relaxed)) {
+            task = DEQUE_EMPTY;
+        }
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_release);
+    }
+    return task;
+}
+
+// any thread
+int dequeSteal(Deque* d) {
+    long t = atomic_load_explicit(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+
+    if (t >= b) return DEQUE_EMPTY;
+
+    int task = atomic_load_explicit(&d->buffer[t & d->mask], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1,
+                                                 memory_order_seq_cst, memory_order_relaxed)) {
+        // lost to the owner or another thief
+        return DEQUE_EMPTY;
+    }
+    return task;
+}
+
+void* stealWorker(void* arg) {
+    WorkerArgs* args = (WorkerArgs*)arg;
+    StealPool* pool = args->pool;
+    int id = args->id;
+    Deque* own = &pool->deques[id];
+    int seen = 0;
+
+    while (1) {
+        pthread_mutex_lock(&pool->lock);
+        while (atomic_load(&pool->round) == seen && !pool->stop) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->stop) {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+        seen = atomic_load(&pool->round);
+        int count = pool->taskCount;
+        pthread_mutex_unlock(&pool->lock);
+
+        // push our contiguous share backwards so pops run it in order
+        int lo = (int)((long)count * id / pool->thread_count);
+        int hi = (int)((long)count * (id + 1) / pool->thread_count);
+        for (int t = hi - 1; t >= lo; t--) {
+            dequePush(own, t);
+        }
+
+        while (1) {
+            int task = dequePop(own);
+            if (task == DEQUE_EMPTY) {
+                for (int i = 1; i < pool->thread_count && task == DEQUE_EMPTY; i++) {
+                    task = dequeSteal(&pool->deques[(id + i) % pool->thread_count]);
+                }
+                if (task != DEQUE_EMPTY) own->steals++;
+            }
+
+            if (task != DEQUE_EMPTY) {
+                pool->run(pool->ctx, task);
+                own->tasksRun++;
+                latchCountDown(&pool->pending);
+                continue;
+            }
+
+            // nothing to take: the round is over, or a newer one needs our share
+            if (atomic_load(&pool->pending.count) == 0 || atomic_load(&pool->round) != seen) break;
+            sched_yield();
+        }
+    }
+
+    free(args);
+    return NULL;
+}
+
+StealPool* createStealPool(int threadCount, int maxTasks) {
+    StealPool* pool = (StealPool*) malloc(sizeof(StealPool));
+    if (!pool) {
+        perror("failed to allocate steal pool");
+        exit(EXIT_FAILURE);
+    }
+    pool->thread_count = threadCount;
+    pool->maxTasks = maxTasks;
+    pool->run = NULL;
+    pool->ctx = NULL;
+    pool->taskCount = 0;
+    initLatch(&pool->pending);
+    atomic_init(&pool->round, 0);
+    pool->stop = 0;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+
+    // a worker never holds more than its share of one round
+    long capacity = 1;
+    while (capacity < maxTasks) capacity <<= 1;
+
+    pool->deques = aligned_alloc(64, threadCount * sizeof(Deque));
+    pool->threads = malloc(threadCount * sizeof(pthread_t));
+    if (!pool->deques || !pool->threads) {
+        perror("failed to allocate steal pool");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < threadCount; i++) {
+        Deque* d = &pool->deques[i];
+        atomic_init(&d->top, 0);
+        atomic_init(&d->bottom, 0);
+        d->buffer = malloc(capacity * sizeof(atomic_int));
+        if (!d->buffer) {
+            perror("failed to allocate deque");
+            exit(EXIT_FAILURE);
+        }
+        d->mask = capacity - 1;
+        d->tasksRun = 0;
+        d->steals = 0;
+    }
+
+    for (int i = 0; i < threadCount; i++) {
+        WorkerArgs* args = malloc(sizeof(WorkerArgs));
+        args->pool = pool;
+        args->id = i;
+        if (pthread_create(&pool->threads[i], NULL, stealWorker, args)) {
+            perror("failed to initialize threads");
+            exit(EXIT_FAILURE);
+        }
+    }
+    return pool;
+}
+
+void runTasks(StealPool* pool, int taskCount, void (*run)(void* ctx, int task), void* ctx) {
+    if (taskCount <= 0) return;
+    if (taskCount > pool->maxTasks) {
+        fprintf(stderr, "runTasks: %d tasks, pool holds %d\n", taskCount, pool->maxTasks);
+        exit(EXIT_FAILURE);
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->run = run;
+    pool->ctx = ctx;
+    pool->taskCount = taskCount;
+    latchAdd(&pool->pending, taskCount);
+    atomic_fetch_add(&pool->round, 1);
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    latchWait(&pool->pending);
+}
+
+void getStealStats(StealPool* pool, long* tasksRun, long* steals) {
+    *tasksRun = 0;
+    *steals = 0;
+    for (int i = 0; i < pool->thread_count; i++) {
+        *tasksRun += pool->deques[i].tasksRun;
+        *steals += pool->deques[i].steals;
+    }
+}
+
+void destroyStealPool(StealPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    for (int i = 0; i < pool->thread_count; i++) {
+        free(pool->deques[i].buffer);
+    }
+    free(pool->deques);
+    free(pool->threads);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    destroyLatch(&pool->pending);
+    free(pool);
+}
@@ -0,0 +1,54 @@
+#ifndef STEAL_H
+#define STEAL_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include "latch.h"
+
+/*
+ * Work stealing thread pool. Each worker owns a Chase-Lev deque: it pushes
+ * and pops its own share of a round's tasks at the bottom without locks,
+ * and idle workers steal from the top of the others. Tasks are plain
+ * indices into the caller's descriptors, so nothing is allocated per task.
+ */
+
+// one per worker, top and bottom on separate cache lines
+typedef struct __attribute__((aligned(64))) Deque {
+    atomic_long top;                   // thieves take from here
+    char pad[64 - sizeof(atomic_long)];
+    atomic_long bottom;                // the owner pushes and pops here
+    atomic_int* buffer;
+    long mask;                         // capacity - 1, capacity a power of 2
+    long tasksRun;                     // stats, written by the owner only
+    long steals;
+} Deque;
+
+typedef struct StealPool {
+    int thread_count;
+    pthread_t* threads;
+    Deque* deques;
+    int maxTasks;
+
+    // the current round, written by runTasks before round is bumped
+    void (*run)(void* ctx, int task);
+    void* ctx;
+    int taskCount;
+    Latch pending; // tasks of the round not finished yet
+    atomic_int round;
+    int stop;
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake; // a new round or stop
+} StealPool;
+
+StealPool* createStealPool(int threadCount, int maxTasks);
+
+// runs run(ctx, t) for 0 <= t < taskCount on the workers, returns once all are done
+void runTasks(StealPool* pool, int taskCount, void (*run)(void* ctx, int task), void* ctx);
+
+// total tasks run and stolen since the pool was created
+void getStealStats(StealPool* pool, long* tasksRun, long* steals);
+
+void destroyStealPool(StealPool* pool);
+
+#endif
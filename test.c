@@ -1,21 +1,206 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include <unistd.h>
 #include <fcntl.h>
-#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// exit codes, equal is 2 as it always was for the scripts calling this
+#define SAME      2
+#define DIFFERENT 1
+#define FAILED    3 // a file couldn't be opened or mapped, or bad arguments
+
+#define BLOCK (1 << 20) // bytes memcmp'd at a time, the mismatching one is scanned
+#define TOKEN 64        // longest number the numeric mode parses
+
+/*
+ * ./test [-n tolerance] file1 file2
+ * Byte mode maps both files and memcmps them a block at a time, then
+ * reports the first differing offset with its line and column. With -n the
+ * files are read as whitespace separated tokens instead, numbers only have
+ * to match within the relative tolerance and anything else exactly, so
+ * rank dumps from engines that sum in a different order still compare.
+ */
+typedef struct File {
+    const char* path;
+    int fd;
+    size_t size;
+    const char* data; // the whole file, NULL when empty
+} File;
+
+static int openFile(File* f, const char* path) {
+    f->path = path;
+    f->data = NULL;
+    f->fd = open(path, O_RDONLY);
+    if (f->fd < 0) {
+        perror(path);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(f->fd, &st) != 0) {
+        perror(path);
+        close(f->fd);
+        return -1;
+    }
+    f->size = (size_t)st.st_size;
+    if (f->size == 0) return 0;
+    void* p = mmap(NULL, f->size, PROT_READ, MAP_PRIVATE, f->fd, 0);
+    if (p == MAP_FAILED) {
+        perror(path);
+        close(f->fd);
+        return -1;
+    }
+    // read once front to back
+    madvise(p, f->size, MADV_SEQUENTIAL);
+    f->data = (const char*)p;
+    return 0;
+}
+
+static void closeFile(File* f) {
+    if (f->data) munmap((void*)f->data, f->size);
+    close(f->fd);
+}
+
+// 1-based line and column of offset
+static void lineOf(const char* data, size_t offset, long* line, long* column) {
+    const char* p = data;
+    const char* end = data + offset;
+    const char* lineStart = data;
+    *line = 1;
+    while (p < end && (p = memchr(p, '\n', end - p)) != NULL) {
+        (*line)++;
+        lineStart = ++p;
+    }
+    *column = (long)(end - lineStart) + 1;
+}
+
+// offset of the first differing byte, or -1 when the common prefix is all there is
+static long firstDifference(const char* a, const char* b, size_t size) {
+    for (size_t block = 0; block < size; block += BLOCK) {
+        size_t len = size - block < BLOCK ? size - block : BLOCK;
+        if (memcmp(a + block, b + block, len) == 0) continue;
+        // narrow down by halves, each memcmp is vectorized
+        size_t lo = block, hi = block + len;
+        while (hi - lo > 64) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (memcmp(a + lo, b + lo, mid - lo) != 0) hi = mid;
+            else lo = mid;
+        }
+        while (a[lo] == b[lo]) lo++;
+        return (long)lo;
+    }
+    return -1;
+}
+
+static int compareBytes(File* f1, File* f2) {
+    size_t common = f1->size < f2->size ? f1->size : f2->size;
+    long offset = firstDifference(f1->data, f2->data, common);
+    if (offset < 0 && f1->size == f2->size) {
+        printf("equal, %zu bytes\n", f1->size);
+        return SAME;
+    }
+    if (offset < 0) offset = (long)common; // one is a prefix of the other
+    long line, column;
+    lineOf(f1->size > f2->size ? f1->data : f2->data, offset, &line, &column);
+    printf("differ at offset %ld, line %ld, column %ld", offset, line, column);
+    if ((size_t)offset == common) printf(", %s ends there", f1->size == common ? f1->path : f2->path);
+    printf("\n");
+    return DIFFERENT;
+}
+
+static inline int isSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+// start and length of the next token at or after *pos, counting lines; 0 at the end
+static size_t nextToken(File* f, size_t* pos, long* line, size_t* start) {
+    size_t p = *pos;
+    while (p < f->size && isSpace(f->data[p])) {
+        if (f->data[p] == '\n') (*line)++;
+        p++;
+    }
+    *start = p;
+    while (p < f->size && !isSpace(f->data[p])) p++;
+    *pos = p;
+    return p - *start;
+}
+
+// the token as a number, 0 when it isn't entirely one
+static int parseNumber(const char* token, size_t len, double* value) {
+    if (len >= TOKEN) return 0;
+    char buf[TOKEN];
+    memcpy(buf, token, len);
+    buf[len] = '\0';
+    char* end;
+    *value = strtod(buf, &end);
+    return len > 0 && end == buf + len;
+}
+
+static int compareNumbers(File* f1, File* f2, double tolerance) {
+    size_t p1 = 0, p2 = 0;
+    long line1 = 1, line2 = 1, tokens = 0, differing = 0;
+    double maxRel = 0.0;
+    while (1) {
+        size_t s1, s2;
+        size_t n1 = nextToken(f1, &p1, &line1, &s1);
+        size_t n2 = nextToken(f2, &p2, &line2, &s2);
+        if (n1 == 0 && n2 == 0) break;
+        tokens++;
+        // the same text needs no parsing, which is most tokens of a passing run
+        if (n1 == n2 && memcmp(f1->data + s1, f2->data + s2, n1) == 0) continue;
+
+        double v1, v2;
+        if (n1 && n2 && parseNumber(f1->data + s1, n1, &v1) && parseNumber(f2->data + s2, n2, &v2)) {
+            differing++;
+            double diff = fabs(v1 - v2);
+            double scale = fabs(v1) > fabs(v2) ? fabs(v1) : fabs(v2);
+            double rel = scale > 0 ? diff / scale : 0.0;
+            if (rel > maxRel || rel != rel) maxRel = rel;
+            // NaN in either fails
+            if (rel <= tolerance) continue;
+            printf("differ at token %ld, line %ld of %s and %ld of %s: %.9g and %.9g, relative error %e\n",
+                   tokens, line1, f1->path, line2, f2->path, v1, v2, rel);
+            return DIFFERENT;
+        }
+        printf("differ at token %ld, line %ld of %s and %ld of %s: \"%.*s\" and \"%.*s\"\n", tokens, line1,
+               f1->path, line2, f2->path, (int)(n1 < TOKEN ? n1 : TOKEN), n1 ? f1->data + s1 : "",
+               (int)(n2 < TOKEN ? n2 : TOKEN), n2 ? f2->data + s2 : "");
+        return DIFFERENT;
+    }
+    printf("equal within %e, %ld tokens, %ld of them numbers that differ, max relative error %e\n", tolerance,
+           tokens, differing, maxRel);
+    return SAME;
+}
+
 int main(int argc, char** argv)
 {
-    char c1 = 'a', c2 = 'a';
-    int f1 = open(argv[1], O_RDONLY);
-    int f2 = open(argv[2], O_RDONLY);
-    if (!f1 && !f2) exit(2); else if (!f1 || !f2) exit(1);
-
-    while (c1 == c2)
-    {
-        // if both at end of file
-        int size1 = read(f1, &c1, 1);
-        int size2 = read(f2, &c2, 1);
-        if (size1 == 0 && size2 == 0) { close(f1);close(f2);exit(2); }
-    }
-    close(f1); close(f2);
-    exit(1);
-}
\ No newline at end of file
+    double tolerance = -1.0; // byte mode
+    int arg = 1;
+    if (argc > arg + 1 && strcmp(argv[arg], "-n") == 0) {
+        char* end;
+        tolerance = strtod(argv[arg + 1], &end);
+        if (*end != '\0' || tolerance < 0) {
+            fprintf(stderr, "bad tolerance %s\n", argv[arg + 1]);
+            exit(FAILED);
+        }
+        arg += 2;
+    }
+    if (argc - arg != 2) {
+        fprintf(stderr, "usage: %s [-n tolerance] file1 file2\n", argv[0]);
+        exit(FAILED);
+    }
+
+    File f1, f2;
+    if (openFile(&f1, argv[arg]) != 0) exit(FAILED);
+    if (openFile(&f2, argv[arg + 1]) != 0) {
+        closeFile(&f1);
+        exit(FAILED);
+    }
+
+    int result = tolerance < 0 ? compareBytes(&f1, &f2) : compareNumbers(&f1, &f2, tolerance);
+    closeFile(&f1);
+    closeFile(&f2);
+    exit(result);
+}
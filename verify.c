@@ -0,0 +1,265 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "verify.h"
+
+#define RADIX_BITS 16
+#define RADIX (1 << RADIX_BITS)
+
+void initTolerance(Tolerance* tol) {
+    tol->maxAbs = VERIFY_MAX_ABS;
+    tol->maxRel = VERIFY_MAX_REL;
+    tol->maxL1 = VERIFY_MAX_L1;
+    tol->minTau = VERIFY_MIN_TAU;
+    tol->minTopK = VERIFY_MIN_TOP_K;
+    tol->k = VERIFY_TOP_K;
+}
+
+// bits of f that compare as unsigned the way f compares as a float
+static inline uint32_t orderedBits(float f) {
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+}
+
+// LSD radix sort, keys end up in keys, tmp is scratch of the same size
+static void radixSort(uint64_t* keys, uint64_t* tmp, long n) {
+    long* count = (long*)malloc(RADIX * sizeof(long));
+    if (!count) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    for (int shift = 0; shift < 64; shift += RADIX_BITS) {
+        memset(count, 0, RADIX * sizeof(long));
+        for (long i = 0; i < n; i++) count[(keys[i] >> shift) & (RADIX - 1)]++;
+        // a digit every key shares doesn't move anything
+        if (n > 0 && count[(keys[0] >> shift) & (RADIX - 1)] == n) continue;
+        long sum = 0;
+        for (int d = 0; d < RADIX; d++) {
+            long c = count[d];
+            count[d] = sum;
+            sum += c;
+        }
+        for (long i = 0; i < n; i++) tmp[count[(keys[i] >> shift) & (RADIX - 1)]++] = keys[i];
+        memcpy(keys, tmp, n * sizeof(uint64_t));
+    }
+    free(count);
+}
+
+// sorts a with a bottom up merge sort, returns the number of pairs i < j with a[i] > a[j]
+static long countInversions(uint32_t* a, uint32_t* tmp, long n) {
+    uint32_t* sorted = a;
+    long inversions = 0;
+    // runs of 16 by insertion, each shift past a larger element is one inversion
+    for (long lo = 0; lo < n; lo += 16) {
+        long hi = lo + 16 < n ? lo + 16 : n;
+        for (long i = lo + 1; i < hi; i++) {
+            uint32_t v = a[i];
+            long j = i;
+            while (j > lo && a[j - 1] > v) {
+                a[j] = a[j - 1];
+                j--;
+            }
+            inversions += i - j;
+            a[j] = v;
+        }
+    }
+    // then the passes alternate between the two buffers instead of copying back
+    for (long width = 16; width < n; width *= 2) {
+        for (long lo = 0; lo < n; lo += 2 * width) {
+            long mid = lo + width < n ? lo + width : n;
+            long hi = lo + 2 * width < n ? lo + 2 * width : n;
+            long i = lo, j = mid, out = lo;
+            while (i < mid && j < hi) {
+                if (a[j] < a[i]) {
+                    // a[j] is smaller than everything left in the first half
+                    inversions += mid - i;
+                    tmp[out++] = a[j++];
+                } else {
+                    tmp[out++] = a[i++];
+                }
+            }
+            while (i < mid) tmp[out++] = a[i++];
+            while (j < hi) tmp[out++] = a[j++];
+        }
+        uint32_t* swap = a;
+        a = tmp;
+        tmp = swap;
+    }
+    if (a != sorted) memcpy(sorted, a, n * sizeof(uint32_t));
+    return inversions;
+}
+
+// pairs inside runs of keys equal above shift, a is sorted
+static double tiedPairs64(const uint64_t* a, long n, int shift) {
+    double pairs = 0.0;
+    long run = 1;
+    for (long i = 1; i <= n; i++) {
+        if (i < n && (a[i] >> shift) == (a[i - 1] >> shift)) {
+            run++;
+        } else {
+            pairs += (double)run * (run - 1) / 2;
+            run = 1;
+        }
+    }
+    return pairs;
+}
+
+static double tiedPairs32(const uint32_t* a, long n) {
+    double pairs = 0.0;
+    long run = 1;
+    for (long i = 1; i <= n; i++) {
+        if (i < n && a[i] == a[i - 1]) {
+            run++;
+        } else {
+            pairs += (double)run * (run - 1) / 2;
+            run = 1;
+        }
+    }
+    return pairs;
+}
+
+/*
+ * Knight's algorithm: sorted by (x, y), every pair that is out of order in y
+ * is discordant, so counting the inversions of y counts the discordant pairs.
+ * Ties in x, in y and in both come from runs of equal keys.
+ */
+static double kendallTau(const float* x, const float* y, long n) {
+    if (n < 2) return 1.0;
+    uint64_t* keys = (uint64_t*)malloc(n * sizeof(uint64_t));
+    uint64_t* tmp = (uint64_t*)malloc(n * sizeof(uint64_t));
+    if (!keys || !tmp) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    for (long i = 0; i < n; i++) keys[i] = ((uint64_t)orderedBits(x[i]) << 32) | orderedBits(y[i]);
+    radixSort(keys, tmp, n);
+
+    double tiedX = tiedPairs64(keys, n, 32);
+    double tiedXY = tiedPairs64(keys, n, 0);
+
+    // y in (x, y) order, sorted in place by the inversion count
+    uint32_t* ys = (uint32_t*)malloc(n * sizeof(uint32_t));
+    if (!ys) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    for (long i = 0; i < n; i++) ys[i] = (uint32_t)keys[i];
+    free(keys);
+    long discordant = countInversions(ys, (uint32_t*)tmp, n);
+    double tiedY = tiedPairs32(ys, n);
+
+    double pairs = (double)n * (n - 1) / 2;
+    double concordantMinusDiscordant = pairs - tiedX - tiedY + tiedXY - 2.0 * discordant;
+    double denominator = sqrt((pairs - tiedX) * (pairs - tiedY));
+
+    free(ys);
+    free(tmp);
+    return denominator > 0 ? concordantMinusDiscordant / denominator : 1.0;
+}
+
+// i ranks above j: higher value, or the same value and a lower id
+static inline int above(const float* r, long i, long j) {
+    return r[i] > r[j] || (r[i] == r[j] && i < j);
+}
+
+static int compareLongs(const void* a, const void* b) {
+    long x = *(const long*)a, y = *(const long*)b;
+    return (x > y) - (x < y);
+}
+
+// ids of the k highest ranks in id order, with a min heap of the best k so far
+static void topK(const float* r, long n, int k, long* out) {
+    int size = 0;
+    for (long i = 0; i < n; i++) {
+        if (size == k && !above(r, i, out[0])) continue;
+        // push, or replace the root, then sift down from where the new id sits
+        int pos = size < k ? size++ : 0;
+        if (pos > 0) {
+            while (pos > 0 && above(r, out[(pos - 1) / 2], i)) {
+                out[pos] = out[(pos - 1) / 2];
+                pos = (pos - 1) / 2;
+            }
+            out[pos] = i;
+            continue;
+        }
+        while (1) {
+            int child = 2 * pos + 1;
+            if (child >= size) break;
+            if (child + 1 < size && above(r, out[child], out[child + 1])) child++;
+            if (!above(r, i, out[child])) break;
+            out[pos] = out[child];
+            pos = child;
+        }
+        out[pos] = i;
+    }
+    qsort(out, size, sizeof(long), compareLongs);
+}
+
+static double topKOverlap(const float* expected, const float* actual, long n, int k) {
+    if (k <= 0) return 1.0;
+    long* a = (long*)malloc(k * sizeof(long));
+    long* b = (long*)malloc(k * sizeof(long));
+    if (!a || !b) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    topK(expected, n, k, a);
+    topK(actual, n, k, b);
+    int common = 0;
+    for (int i = 0, j = 0; i < k && j < k;) {
+        if (a[i] == b[j]) {
+            common++;
+            i++;
+            j++;
+        } else if (a[i] < b[j]) {
+            i++;
+        } else {
+            j++;
+        }
+    }
+    free(a);
+    free(b);
+    return (double)common / k;
+}
+
+int verifyRanks(const float* expected, const float* actual, long n, const Tolerance* tol, VerifyResult* result) {
+    memset(result, 0, sizeof(*result));
+    result->n = n;
+
+    for (long i = 0; i < n; i++) {
+        double diff = fabs((double)actual[i] - expected[i]);
+        double rel = expected[i] != 0 ? diff / fabs(expected[i]) : (diff > 0 ? INFINITY : 0.0);
+        // NaN fails the comparison, so it is taken as the worst error
+        if (!(diff <= result->maxAbs)) {
+            result->maxAbs = isnan(diff) ? INFINITY : diff;
+            result->maxAbsAt = i;
+        }
+        if (!(rel <= result->maxRel)) {
+            result->maxRel = isnan(rel) ? INFINITY : rel;
+            result->maxRelAt = i;
+        }
+        result->l1 += diff;
+    }
+
+    result->tau = kendallTau(expected, actual, n);
+    result->k = tol->k < n ? tol->k : (int)n;
+    result->topK = topKOverlap(expected, actual, n, result->k);
+
+    result->pass = (tol->maxAbs < 0 || result->maxAbs <= tol->maxAbs) &&
+                   (tol->maxRel < 0 || result->maxRel <= tol->maxRel) &&
+                   (tol->maxL1 < 0 || result->l1 <= tol->maxL1) &&
+                   (tol->minTau < 0 || result->tau >= tol->minTau) &&
+                   (tol->minTopK < 0 || result->topK >= tol->minTopK);
+    return result->pass;
+}
+
+void printVerify(const char* name1, const char* name2, const VerifyResult* result) {
+    // some terminal sugar
+    printf("%-6s and %-8s are \e[1m%s\e[m  max abs %.3e (at %ld)  max rel %.3e (at %ld)  L1 %.3e"
+           "  tau %.6f  top-%d %.3f\n",
+           name1, name2, result->pass ? "equal" : "different", result->maxAbs, result->maxAbsAt,
+           result->maxRel, result->maxRelAt, result->l1, result->tau, result->k, result->topK);
+}
@@ -0,0 +1,53 @@
+#ifndef VERIFY_H
+#define VERIFY_H
+
+// defaults of initTolerance, a negative tolerance turns its check off
+#define VERIFY_MAX_ABS   -1.0  // off, the size of a rank depends on N
+#define VERIFY_MAX_REL   1e-5  // reordered float sums stay well within this
+#define VERIFY_MAX_L1    1e-4
+#define VERIFY_MIN_TAU   0.99
+#define VERIFY_MIN_TOP_K 0.9
+#define VERIFY_TOP_K     100
+
+/*
+ * Compares a result against a reference one, the way a faster engine has to
+ * match: up to rounding, not bit for bit. Besides the errors per vertex it
+ * compares the two orderings, Kendall's tau-b over all pairs, computed with
+ * Knight's O(n log n) algorithm on radix sorted keys, and the overlap of the
+ * k highest ranked vertices. 10M vertices take about a second.
+ */
+struct Tolerance {
+    double maxAbs;  // largest |actual - expected|
+    double maxRel;  // largest |actual - expected| / |expected|
+    double maxL1;   // sum of |actual - expected|
+    double minTau;  // Kendall tau-b of the two orderings, 1 is the same order
+    double minTopK; // share of the top k vertices of expected also in the top k of actual
+    int k;
+};
+
+typedef struct Tolerance Tolerance;
+
+struct VerifyResult {
+    long n;
+    double maxAbs;
+    long maxAbsAt;  // vertex of maxAbs
+    double maxRel;
+    long maxRelAt;
+    double l1;
+    double tau;     // 1 when there are fewer than 2 vertices or no untied pair
+    int k;          // top k compared, at most n
+    double topK;
+    int pass;       // every check that is on held
+};
+
+typedef struct VerifyResult VerifyResult;
+
+void initTolerance(Tolerance* tol);
+
+// fills result, returns result->pass
+int verifyRanks(const float* expected, const float* actual, long n, const Tolerance* tol, VerifyResult* result);
+
+// one line, "name1 and name2 are equal" followed by the numbers
+void printVerify(const char* name1, const char* name2, const VerifyResult* result);
+
+#endif